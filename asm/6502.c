@@ -22,11 +22,19 @@
 //#include "disasm/6502.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 
 #include "table/6502.h"
 
 #define GET_TOKEN() (token_type = tokens_get(asm_context, token, TOKENLEN))
 
+// sizes an address without a modifier can be given
+enum
+{
+  ADDRESS_8,
+  ADDRESS_16,
+};
+
 static int get_num(struct _asm_context *asm_context,
                    char *token, int *token_type,
                    int *num, int *size)
@@ -66,12 +74,31 @@ static int get_num(struct _asm_context *asm_context,
   return 0;
 }
 
+static int get_address_size(struct _asm_context *asm_context,
+                            int num, int known)
+{
+  int wanted;
+
+  // forward references are absolute unless .relax lets pass 1 repeat
+  if(known == 0)
+    wanted = asm_context->relax.enabled == 1 ? RELAX_UNKNOWN : ADDRESS_16;
+  else if(num > 0xFF)
+    wanted = ADDRESS_16;
+  else
+    wanted = ADDRESS_8;
+
+  if(relax_form(asm_context, wanted) == ADDRESS_8)
+    return 8;
+
+  return 16;
+}
+
 static int get_address(struct _asm_context *asm_context,
                        char *token, int *token_type,
                        int *num, int *size)
 {
   char modifier = 0;
-  int worst_case = 0;
+  int known = 1;
 
   // check for modifiers
   if(IS_TOKEN(token, '<'))
@@ -85,29 +112,17 @@ static int get_address(struct _asm_context *asm_context,
   if(eval_expression(asm_context, num) != 0)
   {
     if(asm_context->pass == 1)
+    {
       eat_operand(asm_context);
+      known = 0;
+    }
     else
       return -1;
-
-    // Store a flag in this address to remind on pass 2 that this
-    // instruction can't use zero page.
-    memory_write(asm_context, asm_context->address, 1, asm_context->line);
-    worst_case = 1;
   }
 
-  // On pass 2, figure out if the size of the operand was unknown in pass 1
-  worst_case = memory_read(asm_context, asm_context->address);
-
   // try to guess addressing mode if one hasn't been forced
-  if(*size == 0)
-  {
-    *size = 8;
-
-    if(*num > 0xFF)
-      *size = 16;
-
-    if (*size == 8 && worst_case == 1) { *size = 16; }
-  }
+  if(*size == 0 && modifier == 0)
+    *size = get_address_size(asm_context, *num, known);
 
   if(modifier == '<')
   {
@@ -144,6 +159,7 @@ int parse_instruction_6502(struct _asm_context *asm_context, char *instr)
   int size;
   int bytes;
   int i;
+  int relax_ptr = asm_context->relax.ptr;
 
   // make lowercase
   lower_copy(instr_case, instr);
@@ -356,10 +372,6 @@ int parse_instruction_6502(struct _asm_context *asm_context, char *instr)
           return -1;
         }
 
-        // forward label
-        if(num == 0)
-          size = 16;
-
         if(size == 8)
         {
           if(num > 0xFF)
@@ -393,7 +405,7 @@ int parse_instruction_6502(struct _asm_context *asm_context, char *instr)
           {
             op = OP_INDEXED8_X;
 
-            if(num > 0xFF)
+            if(size == 16 || num > 0xFF)
               op = OP_INDEXED16_X;
 
             if(num > 0xFFFF)
@@ -407,7 +419,7 @@ int parse_instruction_6502(struct _asm_context *asm_context, char *instr)
           {
             op = OP_INDEXED8_Y;
 
-            if(num > 0xFF)
+            if(size == 16 || num > 0xFF)
               op = OP_INDEXED16_Y;
 
             if(num > 0xFFFF)
@@ -475,6 +487,13 @@ int parse_instruction_6502(struct _asm_context *asm_context, char *instr)
   // write output
   bytes = op_bytes[op];
 
+  // a forward reference that ended up in zero page
+  if(asm_context->relax.ptr != relax_ptr && bytes == 2 &&
+     relax_forward(asm_context) == 1)
+  {
+    relax_shortened(asm_context);
+  }
+
   add_bin8(asm_context, opcode & 0xFF, IS_OPCODE);
 
   if(bytes > 1)
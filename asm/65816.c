@@ -22,11 +22,56 @@
 #include "disasm/65816.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 
 #include "table/65816.h"
 
+extern struct _table_65816 table_65816[];
+extern struct _table_65816_opcodes table_65816_opcodes[];
+
 #define GET_TOKEN() (token_type = tokens_get(asm_context, token, TOKENLEN))
 
+// the low 16 bits of extra_context hold the .dp direct page
+#define DIRECT_PAGE(a) ((a)->extra_context & 0xFFFF)
+
+// sizes an address without a modifier can be given
+enum
+{
+  ADDRESS_8,
+  ADDRESS_16,
+  ADDRESS_24,
+};
+
+// widths of the accumulator (M flag) and index registers (X flag) as
+// followed through rep, sep and .a8/.a16/.i8/.i16, kept in bits 16-19
+// of extra_context
+#define WIDTH_UNKNOWN 0
+#define WIDTH_8 1
+#define WIDTH_16 2
+#define WIDTHS(a) (((a)->extra_context >> 16) & 0xF)
+#define WIDTH_A(a) (((a)->extra_context >> 16) & 0x3)
+#define WIDTH_I(a) (((a)->extra_context >> 18) & 0x3)
+
+#define WIDTH_HASH_SIZE 1024
+
+// widths seen at each labelled instruction and at each branch to one,
+// kept in asm_context->cpu_data
+struct _width_entry
+{
+  uint32_t address;
+  uint8_t widths;
+  uint8_t is_label;
+  int next;
+};
+
+struct _widths
+{
+  struct _width_entry *entries;
+  int count;
+  int alloc;
+  int hash[WIDTH_HASH_SIZE];
+};
+
 static int get_num(struct _asm_context *asm_context,
                    char *token, int *token_type,
                    int *num, int *size)
@@ -74,12 +119,66 @@ static int get_num(struct _asm_context *asm_context,
   return 0;
 }
 
+// jmp and jsr only take absolute addresses, so an address that happens
+// to be in the direct page must not be made relative to .dp for them
+static int has_direct_page(int instr_enum)
+{
+  int op;
+  int i;
+
+  for(i = 0; i < 256; i++)
+  {
+    if(table_65816_opcodes[i].instr != instr_enum)
+      continue;
+
+    op = table_65816_opcodes[i].op;
+
+    if(op == OP_ADDRESS8 || op == OP_INDEXED8_X || op == OP_INDEXED8_Y ||
+       op == OP_INDIRECT8 || op == OP_INDIRECT8_LONG ||
+       op == OP_X_INDIRECT8 || op == OP_INDIRECT8_Y ||
+       op == OP_INDIRECT8_Y_LONG)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int get_address_size(struct _asm_context *asm_context,
+                            int instr_enum, int num, int known)
+{
+  int dp = DIRECT_PAGE(asm_context);
+  int wanted;
+
+  // forward references are absolute unless .relax lets pass 1 repeat
+  if(known == 0)
+    wanted = asm_context->relax.enabled == 1 ? RELAX_UNKNOWN : ADDRESS_16;
+  else if(num >= dp && num - dp <= 0xFF && has_direct_page(instr_enum))
+    wanted = ADDRESS_8;
+  else if(num > 0xFFFF)
+    wanted = ADDRESS_24;
+  else
+    wanted = ADDRESS_16;
+
+  switch(relax_form(asm_context, wanted))
+  {
+    case ADDRESS_8:
+      // only reachable while an unknown address is waiting on .relax
+      if(has_direct_page(instr_enum) == 0)
+        return num > 0xFFFF ? 24 : 16;
+      return 8;
+    case ADDRESS_16: return 16;
+    default: return 24;
+  }
+}
+
 static int get_address(struct _asm_context *asm_context,
-                       char *token, int *token_type,
+                       int instr_enum, char *token, int *token_type,
                        int *num, int *size)
 {
   char modifier = 0;
-  int worst_case = 0;
+  int known = 1;
 
   // check for modifiers
   if(IS_TOKEN(token, '<'))
@@ -95,31 +194,22 @@ static int get_address(struct _asm_context *asm_context,
   if(eval_expression(asm_context, num) != 0)
   {
     if(asm_context->pass == 1)
+    {
       eat_operand(asm_context);
+      known = 0;
+    }
     else
       return -1;
-
-    // Store a flag in this address to remind on pass 2 that this
-    // instruction can't use zero page.
-    memory_write(asm_context, asm_context->address, 1, asm_context->line);
-    worst_case = 1;
   }
 
-  // On pass 2, figure out if the size of the operand was unknown in pass 1
-  worst_case = memory_read(asm_context, asm_context->address);
-
   // try to guess addressing mode if one hasn't been forced
-  if(*size == 0)
+  if(*size == 0 && modifier == 0)
   {
-    *size = 8;
-
-    if(*num > 0xFF)
-      *size = 16;
+    *size = get_address_size(asm_context, instr_enum, *num, known);
 
-    if(*num > 0xFFFF)
-      *size = 24;
-
-    if (*size == 8 && worst_case == 1) { *size = 16; }
+    // direct page addresses are relative to .dp
+    if(*size == 8 && known == 1)
+      *num -= DIRECT_PAGE(asm_context);
   }
 
   if(modifier == '<')
@@ -144,8 +234,152 @@ static int get_address(struct _asm_context *asm_context,
   return 0;
 }
 
-extern struct _table_65816 table_65816[];
-extern struct _table_65816_opcodes table_65816_opcodes[];
+static void set_width_a(struct _asm_context *asm_context, int width)
+{
+  asm_context->extra_context &= ~(0x3 << 16);
+  asm_context->extra_context |= width << 16;
+}
+
+static void set_width_i(struct _asm_context *asm_context, int width)
+{
+  asm_context->extra_context &= ~(0x3 << 18);
+  asm_context->extra_context |= width << 18;
+}
+
+static const char *width_name(int width)
+{
+  if(width == WIDTH_8)
+    return "8";
+  else if(width == WIDTH_16)
+    return "16";
+
+  return "?";
+}
+
+// only widths that are known on both sides can disagree
+static int widths_conflict(int a, int b)
+{
+  int n;
+
+  for(n = 0; n < 4; n += 2)
+  {
+    int width_a = (a >> n) & 0x3;
+    int width_b = (b >> n) & 0x3;
+
+    if(width_a != WIDTH_UNKNOWN && width_b != WIDTH_UNKNOWN &&
+       width_a != width_b)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static void widths_free(void *data)
+{
+  struct _widths *table = (struct _widths *)data;
+
+  free(table->entries);
+  free(table);
+}
+
+static struct _widths *widths_get(struct _asm_context *asm_context)
+{
+  struct _widths *table = assembler_get_cpu_data(asm_context, widths_free);
+
+  if(table == NULL)
+  {
+    table = malloc(sizeof(struct _widths));
+    table->entries = NULL;
+    table->count = 0;
+    table->alloc = 0;
+    memset(table->hash, 0xff, sizeof(table->hash));
+
+    assembler_set_cpu_data(asm_context, table, widths_free);
+  }
+
+  return table;
+}
+
+static void check_widths(struct _asm_context *asm_context,
+                         uint32_t address, int is_label)
+{
+  struct _widths *table;
+  struct _width_entry *entry;
+  int widths = WIDTHS(asm_context);
+  int bucket = address & (WIDTH_HASH_SIZE - 1);
+  int n;
+
+  if(widths == 0)
+    return;
+
+  table = widths_get(asm_context);
+
+  for(n = table->hash[bucket]; n != -1; n = table->entries[n].next)
+  {
+    entry = &table->entries[n];
+
+    if(entry->address != address || entry->is_label == is_label)
+      continue;
+
+    if(widths_conflict(widths, entry->widths))
+    {
+      int label_widths = is_label ? widths : entry->widths;
+      int branch_widths = is_label ? entry->widths : widths;
+
+      printf("Warning: 0x%04x is reached with a%s,i%s but the label has a%s,i%s at %s:%d\n",
+        address,
+        width_name(branch_widths & 0x3),
+        width_name(branch_widths >> 2),
+        width_name(label_widths & 0x3),
+        width_name(label_widths >> 2),
+        asm_context->filename,
+        asm_context->line);
+
+      break;
+    }
+  }
+
+  if(table->count == table->alloc)
+  {
+    table->alloc += WIDTH_HASH_SIZE;
+    table->entries = realloc(table->entries,
+                             table->alloc * sizeof(struct _width_entry));
+  }
+
+  entry = &table->entries[table->count];
+  entry->address = address;
+  entry->widths = widths;
+  entry->is_label = is_label;
+  entry->next = table->hash[bucket];
+  table->hash[bucket] = table->count++;
+}
+
+// immediates of these follow the accumulator or index register width
+static int get_immediate_width(struct _asm_context *asm_context,
+                               int instr_enum)
+{
+  switch(instr_enum)
+  {
+    case M65816_ADC:
+    case M65816_AND:
+    case M65816_BIT:
+    case M65816_CMP:
+    case M65816_EOR:
+    case M65816_LDA:
+    case M65816_ORA:
+    case M65816_SBC:
+      return WIDTH_A(asm_context);
+    case M65816_CPX:
+    case M65816_CPY:
+    case M65816_LDX:
+    case M65816_LDY:
+      return WIDTH_I(asm_context);
+    default:
+      return WIDTH_UNKNOWN;
+  }
+}
 
 // bytes for each addressing mode
 static int op_bytes[] =
@@ -157,6 +391,48 @@ static int op_bytes[] =
 int parse_directive_65816(struct _asm_context *asm_context,
                           const char *directive)
 {
+  int num;
+
+  if(strcasecmp(directive, "dp") == 0)
+  {
+    if(eval_expression(asm_context, &num) != 0)
+    {
+      print_error("dp expects an address known on pass 1", asm_context);
+      return -1;
+    }
+
+    if(num < 0 || num > 0xFFFF)
+    {
+      print_error_range("Direct page", 0, 0xFFFF, asm_context);
+      return -1;
+    }
+
+    asm_context->extra_context &= ~0xFFFF;
+    asm_context->extra_context |= num;
+
+    return 0;
+  }
+  else if(strcasecmp(directive, "a8") == 0)
+  {
+    set_width_a(asm_context, WIDTH_8);
+    return 0;
+  }
+  else if(strcasecmp(directive, "a16") == 0)
+  {
+    set_width_a(asm_context, WIDTH_16);
+    return 0;
+  }
+  else if(strcasecmp(directive, "i8") == 0)
+  {
+    set_width_i(asm_context, WIDTH_8);
+    return 0;
+  }
+  else if(strcasecmp(directive, "i16") == 0)
+  {
+    set_width_i(asm_context, WIDTH_16);
+    return 0;
+  }
+
   return 1;
 }
 
@@ -174,10 +450,17 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
   int bytes = 0;
   int i = 0;
   int src = 0, dst = 0;
+  int width = 0;
+  int relax_ptr = asm_context->relax.ptr;
+  int target = -1;
 
   // make lowercase
   lower_copy(instr_case, instr);
 
+  if(asm_context->pass == 2 &&
+     asm_context->label_address == asm_context->address)
+    check_widths(asm_context, asm_context->address, 1);
+
   // get instruction from string
   instr_enum = -1;
 
@@ -282,6 +565,8 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
 
         if(asm_context->pass == 2)
         {
+          target = num;
+
           // calculate branch offset, need to add 2 to current
           // address, since thats where the program counter would be
           num -= (asm_context->address + 2);
@@ -326,6 +611,8 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
 
         if(asm_context->pass == 2)
         {
+          target = num;
+
           // calculate branch offset, need to add 3 to current
           // address, since thats where the program counter would be
           num -= (asm_context->address + 3);
@@ -347,7 +634,10 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
       if(GET_TOKEN() == TOKEN_EOL)
         break;
 
-      if(get_address(asm_context, token, &token_type, &num, &size) == -1)
+      // banks, not direct page addresses
+      size = 8;
+
+      if(get_address(asm_context, instr_enum, token, &token_type, &num, &size) == -1)
         return -1;
 
       src = num;
@@ -375,7 +665,7 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
       if(GET_TOKEN() == TOKEN_EOL)
         break;
 
-      if(get_address(asm_context, token, &token_type, &num, &size) == -1)
+      if(get_address(asm_context, instr_enum, token, &token_type, &num, &size) == -1)
         return -1;
 
       dst = num;
@@ -400,6 +690,21 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
 
         op = OP_IMMEDIATE16;
 
+        // follow the tracked register width unless forced
+        width = get_immediate_width(asm_context, instr_enum);
+
+        if(size == 0 && width == WIDTH_8)
+          size = 8;
+        else if(size == 0 && width == WIDTH_16)
+          size = 16;
+        else if(asm_context->pass == 2 &&
+                ((size == 8 && width == WIDTH_16) ||
+                 (size == 16 && width == WIDTH_8)))
+        {
+          printf("Warning: %d-bit immediate but the register is %s-bit at %s:%d\n",
+            size, width_name(width), asm_context->filename, asm_context->line);
+        }
+
         // value was forced with .b, .w, or .l
 	if(size == 8)
         {
@@ -443,7 +748,7 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
         if(GET_TOKEN() == TOKEN_EOL)
           break;
 
-        if(get_address(asm_context, token, &token_type, &num, &size) == -1)
+        if(get_address(asm_context, instr_enum, token, &token_type, &num, &size) == -1)
           return -1;
 
         if(GET_TOKEN() == TOKEN_EOL)
@@ -554,7 +859,7 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
         if(GET_TOKEN() == TOKEN_EOL)
           break;
 
-        if(get_address(asm_context, token, &token_type, &num, &size) == -1)
+        if(get_address(asm_context, instr_enum, token, &token_type, &num, &size) == -1)
           return -1;
 
         if(GET_TOKEN() == TOKEN_EOL)
@@ -596,7 +901,7 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
         if(GET_TOKEN() == TOKEN_EOL)
           break;
 
-        if(get_address(asm_context, token, &token_type, &num, &size) == -1)
+        if(get_address(asm_context, instr_enum, token, &token_type, &num, &size) == -1)
           return -1;
 
         if(num < 0 || num > 0xFFFFFF)
@@ -605,10 +910,6 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
           return -1;
         }
 
-        // forward label
-        if(num == 0)
-          size = 16;
-
         if(size == 8)
         {
           if(num > 0xFF)
@@ -779,6 +1080,37 @@ int parse_instruction_65816(struct _asm_context *asm_context, char *instr)
   else
     bytes = op_bytes[op];
 
+  if(asm_context->pass == 2)
+  {
+    if((instr_enum == M65816_JMP || instr_enum == M65816_JSR) &&
+       (op == OP_ADDRESS16 || op == OP_ADDRESS24))
+    {
+      target = num;
+    }
+
+    if(target != -1)
+      check_widths(asm_context, target, 0);
+  }
+
+  // rep and sep change the widths of everything after them
+  if(instr_enum == M65816_REP || instr_enum == M65816_SEP)
+  {
+    width = instr_enum == M65816_REP ? WIDTH_16 : WIDTH_8;
+
+    if(num & 0x20)
+      set_width_a(asm_context, width);
+
+    if(num & 0x10)
+      set_width_i(asm_context, width);
+  }
+
+  // a forward reference that ended up in the direct page
+  if(asm_context->relax.ptr != relax_ptr && bytes == 2 &&
+     relax_forward(asm_context) == 1)
+  {
+    relax_shortened(asm_context);
+  }
+
   // write output
   add_bin8(asm_context, opcode & 0xFF, IS_OPCODE);
 
@@ -19,6 +19,7 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "disasm/arm.h"
 #include "table/68000.h"
 
@@ -56,6 +57,27 @@ enum
   SIZE_S,
 };
 
+// Sizes an absolute address without .w or .l can be given.
+enum
+{
+  ADDRESS_SHORT,
+  ADDRESS_LONG,
+};
+
+// Sizes a branch without .s, .w or .l can be given.
+enum
+{
+  BRANCH_SHORT,
+  BRANCH_WORD,
+};
+
+// Forms move.l, add and sub with an immediate can be given.
+enum
+{
+  IMMEDIATE_QUICK,
+  IMMEDIATE_FULL,
+};
+
 enum
 {
   SPECIAL_CCR,
@@ -78,7 +100,7 @@ struct _operand
 {
   int value;
   int type;
-  //char error;
+  char error;
   char dis_reg;
   char xn_reg;
   char xn_size;
@@ -739,7 +761,8 @@ static int write_quick(struct _asm_context *asm_context, char *instr, struct _op
   {
     //if (size != SIZE_NONE) { return 0; }
     if (operands[1].type != OPERAND_D_REG) { return 0; }
-    if (operands[0].value < -128 || operands[0].value > 127)
+    if (operands[0].error == 0 &&
+       (operands[0].value < -128 || operands[0].value > 127))
     {
       print_error_range("Quick", -128, 127, asm_context);
       return -1;
@@ -750,7 +773,8 @@ static int write_quick(struct _asm_context *asm_context, char *instr, struct _op
   }
 
   //if (size == SIZE_NONE) { return 0; }
-  if (operands[0].value < 1 || operands[0].value > 8)
+  if (operands[0].error == 0 &&
+     (operands[0].value < 1 || operands[0].value > 8))
   {
     print_error_range("Quick", 1, 8, asm_context);
     return -1;
@@ -1027,19 +1051,42 @@ static int write_logic_ccr(struct _asm_context *asm_context, char *instr, struct
   return 4;
 }
 
+static int get_branch_size(struct _asm_context *asm_context, struct _operand *operand)
+{
+  int offset = operand->value - (asm_context->address + 2);
+  int wanted;
+
+  // An 8 bit displacement of 0 or -1 means a 16 or 32 bit one follows.
+  if (operand->error == 1)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  if (offset >= -128 && offset <= 127 && offset != 0 && offset != -1)
+  {
+    wanted = BRANCH_SHORT;
+  }
+    else
+  {
+    wanted = BRANCH_WORD;
+  }
+
+  return relax_form(asm_context, wanted) == BRANCH_SHORT ? SIZE_B : SIZE_W;
+}
+
 static int write_branch(struct _asm_context *asm_context, char *instr, struct _operand *operands, int operand_count, int opcode, int size)
 {
   if (operand_count != 1) { return 0; }
   if (operands[0].type != OPERAND_ADDRESS) { return 0; }
 
-  if (asm_context->pass == 1)
+  // Without a size use the smallest displacement that reaches.
+  if (size == SIZE_NONE)
   {
-    if (size == SIZE_NONE)
-    {
-      print_error_internal(asm_context, __FILE__, __LINE__);
-      return -1;
-    }
+    size = get_branch_size(asm_context, &operands[0]);
+  }
 
+  if (asm_context->pass == 1)
+  {
     add_bin16(asm_context, (size + 1) << 8, IS_OPCODE);
     int n;
     for (n = 0; n < size; n++) { add_bin16(asm_context, 0, IS_OPCODE); }
@@ -1069,7 +1116,7 @@ static int write_branch(struct _asm_context *asm_context, char *instr, struct _o
   if (size == SIZE_W)
   {
     offset = operands[0].value - (asm_context->address + 2);
-    if (offset < -32768 && offset > 32767)
+    if (offset < -32768 || offset > 32767)
     {
       print_error_range("Offset", -32768, 32767, asm_context);
       return -1;
@@ -1330,6 +1377,58 @@ static int write_jump(struct _asm_context *asm_context, char *instr, struct _ope
   return ea_generic_new(asm_context, &operands[0], instr, size, table, 1, NO_EXTRA_IMM, 0);
 }
 
+static int get_address_type(struct _asm_context *asm_context, int address, int known)
+{
+  int wanted;
+
+  if (known == 0)
+  {
+    wanted = asm_context->relax.enabled == 1 ? RELAX_UNKNOWN : ADDRESS_LONG;
+  }
+    else
+  if (asm_context->relax.enabled == 1)
+  {
+    // Absolute short is sign extended so it can reach the bottom 32k
+    // and the top 32k of the 24 bit address space.
+    uint32_t value = address & 0xffffff;
+
+    wanted = (value <= 0x7fff || value >= 0xff8000) ?
+      ADDRESS_SHORT : ADDRESS_LONG;
+  }
+    else
+  {
+    wanted = (address < 0 || address > 0xffff) ? ADDRESS_LONG : ADDRESS_SHORT;
+  }
+
+  if (relax_form(asm_context, wanted) == ADDRESS_SHORT)
+  {
+    return OPERAND_ADDRESS_W;
+  }
+
+  return OPERAND_ADDRESS_L;
+}
+
+static int get_quick_form(struct _asm_context *asm_context, struct _operand *operand, int min, int max)
+{
+  int wanted;
+
+  if (operand->error == 1)
+  {
+    wanted = asm_context->relax.enabled == 1 ? RELAX_UNKNOWN : IMMEDIATE_FULL;
+  }
+    else
+  if (operand->value >= min && operand->value <= max)
+  {
+    wanted = IMMEDIATE_QUICK;
+  }
+    else
+  {
+    wanted = IMMEDIATE_FULL;
+  }
+
+  return relax_form(asm_context, wanted);
+}
+
 int parse_instruction_68000(struct _asm_context *asm_context, char *instr)
 {
 char token[TOKENLEN];
@@ -1416,7 +1515,7 @@ int n;
         if (asm_context->pass == 1)
         {
           eat_operand(asm_context);
-          //operands[operand_count].error = 1;
+          operands[operand_count].error = 1;
         }
           else
         {
@@ -1496,13 +1595,11 @@ int n;
             token_type = tokens_get(asm_context, token, TOKENLEN);
             if (strcasecmp(token, "w") == 0)
             {
-              //memory_write(asm_context, asm_context->address, 2, asm_context->line);
               operands[operand_count].type = OPERAND_ADDRESS_W;
             }
               else
             if (strcasecmp(token, "l") == 0)
             {
-              memory_write(asm_context, asm_context->address, 4, asm_context->line);
               operands[operand_count].type = OPERAND_ADDRESS_L;
             }
               else
@@ -1513,17 +1610,8 @@ int n;
           }
             else
           {
-            if (eval_error == 1 || num > 0xffff)
-            {
-              // Can't figure out the size, so assume 32 bit :(
-              memory_write(asm_context, asm_context->address, 4, asm_context->line);
-              operands[operand_count].type = OPERAND_ADDRESS_L;
-            }
-              else
-            {
-              //memory_write(asm_context, asm_context->address, 2, asm_context->line);
-              operands[operand_count].type = OPERAND_ADDRESS_W;
-            }
+            operands[operand_count].type =
+              get_address_type(asm_context, num, eval_error == 0);
 
             tokens_push(asm_context, token, token_type);
           }
@@ -1644,11 +1732,6 @@ int n;
             return -1;
           }
 
-          if (eval_error == 1)
-          {
-            memory_write(asm_context, asm_context->address, 4, asm_context->line);
-          }
-
           token_type = tokens_get(asm_context, token, TOKENLEN);
 
           if (IS_TOKEN(token, '.'))
@@ -1675,16 +1758,8 @@ int n;
           }
             else
           {
-            if (memory_read(asm_context, asm_context->address) != 0 ||
-                eval_error == 1 ||
-                num > 0xffff)
-            {
-              operands[operand_count].type = OPERAND_ADDRESS_L;
-            }
-              else
-            {
-              operands[operand_count].type = OPERAND_ADDRESS_W;
-            }
+            operands[operand_count].type =
+              get_address_type(asm_context, num, eval_error == 0);
 
             tokens_push(asm_context, token, token_type);
           }
@@ -1694,15 +1769,13 @@ int n;
       else
     {
       tokens_push(asm_context, token, token_type);
-      //int eval_error = 0;
 
       if (eval_expression(asm_context, &num) != 0)
       {
         if (asm_context->pass == 1)
         {
           eat_operand(asm_context);
-          //memory_write(asm_context, asm_context->address, 4, asm_context->line);
-          //eval_error = 1;
+          operands[operand_count].error = 1;
         }
           else
         {
@@ -1711,19 +1784,6 @@ int n;
         }
       }
 
-#if 0
-      if (memory_read(asm_context, asm_context->address) != 0 ||
-          eval_error == 1 ||
-          num > 0xffff)
-      {
-        operands[operand_count].type = OPERAND_ADDRESS_L;
-      }
-        else
-      {
-        operands[operand_count].type = OPERAND_ADDRESS_W;
-      }
-#endif
-
       operands[operand_count].type = OPERAND_ADDRESS;
       operands[operand_count].value = num;
     }
@@ -1846,8 +1906,9 @@ printf("\n");
       else
     if (operands[0].type == OPERAND_IMMEDIATE)
     {
-      if (operands[0].value >= 1 && operands[0].value <= 8)
+      if (get_quick_form(asm_context, &operands[0], 1, 8) == IMMEDIATE_QUICK)
       {
+        if (asm_context->relax.enabled == 1) { relax_shortened(asm_context); }
         instr_case = "addq";
       }
         else
@@ -1857,6 +1918,34 @@ printf("\n");
     }
   }
 
+  // With .relax sub #1-8 becomes subq and move.l #-128-127,dN becomes
+  // moveq.
+  if (asm_context->relax.enabled == 1 && operand_count == 2 &&
+      operands[0].type == OPERAND_IMMEDIATE)
+  {
+    if (strcmp(instr_case, "sub") == 0 &&
+        operands[1].type != OPERAND_A_REG &&
+        operand_size != SIZE_NONE)
+    {
+      if (get_quick_form(asm_context, &operands[0], 1, 8) == IMMEDIATE_QUICK)
+      {
+        relax_shortened(asm_context);
+        instr_case = "subq";
+      }
+    }
+      else
+    if (strcmp(instr_case, "move") == 0 &&
+        operands[1].type == OPERAND_D_REG &&
+        operand_size == SIZE_L)
+    {
+      if (get_quick_form(asm_context, &operands[0], -128, 127) == IMMEDIATE_QUICK)
+      {
+        relax_shortened(asm_context);
+        instr_case = "moveq";
+      }
+    }
+  }
+
   // DBcc - Decrement and branch on condition
   if (instr_case[0] == 'd' && instr_case[1] == 'b')
   {
@@ -1914,16 +2003,13 @@ printf("\n");
       int opcode = 0x6000 | (n << 8);
       if (operand_size == SIZE_S) { operand_size = SIZE_B; }
 
-      if (operand_size == -1)
-      {
-        break;
-      }
-
       return write_branch(asm_context, instr, operands, operand_count, opcode, operand_size);
     }
   }
 
-  if (operand_size == SIZE_S && strcmp(instr_case, "bra") != 0)
+  if (operand_size == SIZE_S &&
+      strcmp(instr_case, "bra") != 0 &&
+      strcmp(instr_case, "bsr") != 0)
   {
     print_error_unexp("s", asm_context);
     return -1;
@@ -1963,7 +2049,9 @@ printf("\n");
         }
       }
 
-      if (check_size(operand_size, table_68000[n].omit_size) != 0)
+      // Branches without a size pick their own.
+      if (check_size(operand_size, table_68000[n].omit_size) != 0 &&
+          (table_68000[n].type != OP_BRANCH || operand_size != SIZE_NONE))
       {
         n++;
         continue;
@@ -19,6 +19,7 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "table/6809.h"
 
 #define CHECK_BYTES(a) \
@@ -77,6 +78,22 @@ enum
 #define REG_FLAG_D 0x100
 #define REG_FLAG_S 0x200
 
+// extra_context holds the page set with .setdp.
+#define SETDP_PAGE 0xff
+#define SETDP_VALID 0x100
+
+enum
+{
+  ADDRESS_DIRECT,
+  ADDRESS_EXTENDED,
+};
+
+enum
+{
+  BRANCH_SHORT,
+  BRANCH_LONG,
+};
+
 struct _aliases
 {
   const char *name;
@@ -375,6 +392,125 @@ static int check_indexed(struct _asm_context *asm_context, struct _operand *oper
   return -1;
 }
 
+static int has_direct(const char *instr)
+{
+  int n;
+
+  for (n = 0; table_6809[n].instr != NULL; n++)
+  {
+    if (table_6809[n].operand_type == M6809_OP_DIRECT &&
+        strcmp(instr, table_6809[n].instr) == 0)
+    {
+      return 1;
+    }
+  }
+
+  for (n = 0; table_6809_16[n].instr != NULL; n++)
+  {
+    if (table_6809_16[n].operand_type == M6809_OP_DIRECT &&
+        strcmp(instr, table_6809_16[n].instr) == 0)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int get_address_form(struct _asm_context *asm_context, struct _operand *operand)
+{
+  int page = asm_context->extra_context & SETDP_PAGE;
+  int wanted;
+
+  // A label further down in the file is only known once pass 1 is
+  // repeated so without .relax it stays extended.
+  if (operand->use_long == 1)
+  {
+    wanted = asm_context->relax.enabled == 1 ? RELAX_UNKNOWN : ADDRESS_EXTENDED;
+  }
+    else
+  if (operand->value >= 0 && operand->value <= 0xffff &&
+      (operand->value >> 8) == page)
+  {
+    wanted = ADDRESS_DIRECT;
+  }
+    else
+  {
+    wanted = ADDRESS_EXTENDED;
+  }
+
+  return relax_form(asm_context, wanted);
+}
+
+static int write_long_branch(struct _asm_context *asm_context, struct _operand *operand, int opcode)
+{
+  int offset;
+
+  // bra and bsr have their own long opcodes, the conditionals are
+  // prefixed with 0x10.
+  if (opcode == 0x20 || opcode == 0x8d)
+  {
+    offset = operand->value - (asm_context->address + 3);
+    add_bin8(asm_context, opcode == 0x20 ? 0x16 : 0x17, IS_OPCODE);
+    add_bin16(asm_context, offset & 0xffff, IS_OPCODE);
+    return 3;
+  }
+
+  offset = operand->value - (asm_context->address + 4);
+  add_bin16(asm_context, 0x1000 | opcode, IS_OPCODE);
+  add_bin16(asm_context, offset & 0xffff, IS_OPCODE);
+
+  return 4;
+}
+
+static int get_branch_form(struct _asm_context *asm_context, struct _operand *operand)
+{
+  int offset = operand->value - (asm_context->address + 2);
+  int wanted;
+
+  if (operand->use_long == 1)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  if (offset >= -128 && offset <= 127)
+  {
+    wanted = BRANCH_SHORT;
+  }
+    else
+  {
+    wanted = BRANCH_LONG;
+  }
+
+  return relax_form(asm_context, wanted);
+}
+
+int parse_directive_6809(struct _asm_context *asm_context, const char *directive)
+{
+  int num;
+
+  if (strcasecmp(directive, "setdp") == 0)
+  {
+    if (eval_expression(asm_context, &num) != 0)
+    {
+      print_error("setdp expects a page known on pass 1", asm_context);
+      return -1;
+    }
+
+    if (num < 0 || num > 0xff)
+    {
+      print_error_range("Direct page", 0, 0xff, asm_context);
+      return -1;
+    }
+
+    asm_context->extra_context = SETDP_VALID | num;
+
+    return 0;
+  }
+
+  return 1;
+}
+
 int parse_instruction_6809(struct _asm_context *asm_context, char *instr)
 {
   char token[TOKENLEN];
@@ -607,6 +743,21 @@ int parse_instruction_6809(struct _asm_context *asm_context, char *instr)
 
 //printf("%s %d\n", instr, operand.type);
 
+  // Once .setdp says where the direct page is, an address in it uses
+  // direct addressing the same as if it was written with >.
+  if (operand.type == OPERAND_ADDRESS &&
+      (asm_context->extra_context & SETDP_VALID) != 0 &&
+      has_direct(instr_case))
+  {
+    if (get_address_form(asm_context, &operand) == ADDRESS_DIRECT)
+    {
+      if (relax_forward(asm_context) == 1) { relax_shortened(asm_context); }
+
+      operand.type = OPERAND_DP_ADDRESS;
+      operand.value &= 0xff;
+    }
+  }
+
   n = 0;
   while(1)
   {
@@ -671,6 +822,12 @@ int parse_instruction_6809(struct _asm_context *asm_context, char *instr)
           if (operand.type != OPERAND_ADDRESS) { break; }
           if (table_6809[n].bytes == 2)
           {
+            // A branch that doesn't reach becomes lbra, lbsr or lbcc.
+            if (get_branch_form(asm_context, &operand) == BRANCH_LONG)
+            {
+              return write_long_branch(asm_context, &operand, table_6809[n].opcode);
+            }
+
             uint32_t offset = operand.value - (asm_context->address + 2);
             if (asm_context->pass == 2)
             {
@@ -683,6 +840,15 @@ int parse_instruction_6809(struct _asm_context *asm_context, char *instr)
             add_bin8(asm_context, (uint8_t)offset, IS_OPCODE);
             return 2;
           }
+            else
+          if (table_6809[n].bytes == 3)
+          {
+            // lbra and lbsr
+            uint32_t offset = operand.value - (asm_context->address + 3);
+            add_bin8(asm_context, table_6809[n].opcode, IS_OPCODE);
+            add_bin16(asm_context, (uint16_t)offset, IS_OPCODE);
+            return 3;
+          }
 
           break;
         }
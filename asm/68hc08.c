@@ -18,6 +18,7 @@
 #include "asm/68hc08.h"
 #include "common/assembler.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "common/tokens.h"
 #include "table/68hc08.h"
 
@@ -35,13 +36,136 @@ enum
   OPERAND_SP,
 };
 
+enum
+{
+  ADDRESS_DIRECT,
+  ADDRESS_EXTENDED,
+};
+
 struct _operands
 {
   int value;
   char type;
   char error;
+  char extended;
 };
 
+static int is_direct(struct _operands *operand)
+{
+  return operand->value<=0xff && operand->extended==0;
+}
+
+static int is_branch_target(const char *instr, int index, int operand_count)
+{
+  int n;
+
+  // The offset of a branch is always the last operand.
+  if (index!=operand_count-1) { return 0; }
+
+  for (n=0; n<256; n++)
+  {
+    if (m68hc08_table[n].instr==NULL) { continue; }
+    if (strcmp(m68hc08_table[n].instr, instr)!=0) { continue; }
+
+    switch(m68hc08_table[n].operand_type)
+    {
+      case CPU08_OP_NUM8_REL:
+      case CPU08_OP_OPR8_REL:
+      case CPU08_OP_OPR8_X_PLUS_REL:
+      case CPU08_OP_OPR8_X_REL:
+      case CPU08_OP_REL:
+      case CPU08_OP_X_PLUS_REL:
+      case CPU08_OP_X_REL:
+        return 1;
+      default:
+        if (m68hc08_table[n].operand_type>=CPU08_OP_0_COMMA_OPR_REL &&
+            m68hc08_table[n].operand_type<=CPU08_OP_7_COMMA_OPR_REL)
+        {
+          return 1;
+        }
+        break;
+    }
+  }
+
+  for (n=0; m68hc08_16_table[n].instr!=NULL; n++)
+  {
+    if (m68hc08_16_table[n].operand_type==CPU08_OP_OPR8_SP_REL &&
+        strcmp(m68hc08_16_table[n].instr, instr)==0)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static int has_extended(const char *instr)
+{
+  int n;
+
+  for (n=0; n<256; n++)
+  {
+    if (m68hc08_table[n].instr==NULL) { continue; }
+
+    if ((m68hc08_table[n].operand_type==CPU08_OP_OPR16 ||
+         m68hc08_table[n].operand_type==CPU08_OP_OPR16_X) &&
+        strcmp(m68hc08_table[n].instr, instr)==0)
+    {
+      return 1;
+    }
+  }
+
+  for (n=0; m68hc08_16_table[n].instr!=NULL; n++)
+  {
+    if (m68hc08_16_table[n].operand_type==CPU08_OP_OPR16_SP &&
+        strcmp(m68hc08_16_table[n].instr, instr)==0)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static void get_address_forms(struct _asm_context *asm_context, char *instr, struct _operands *operands, int operand_count)
+{
+  int shortened=0;
+  int wanted;
+  int n;
+
+  // After .relax every address gets a site so one that turns out to be
+  // 0x00 to 0xff can be direct even if its label is further down.
+  for (n=0; n<operand_count; n++)
+  {
+    if (operands[n].type!=OPERAND_ADDRESS) { continue; }
+    if (is_branch_target(instr, n, operand_count)) { continue; }
+
+    if (operands[n].error==1) { wanted=RELAX_UNKNOWN; }
+    else if (operands[n].value<=0xff) { wanted=ADDRESS_DIRECT; }
+    else { wanted=ADDRESS_EXTENDED; }
+
+    if (relax_form(asm_context, wanted)==ADDRESS_EXTENDED)
+    {
+      operands[n].extended=1;
+    }
+      else
+    if (operands[n].error==1)
+    {
+      // Only a placeholder until pass 1 is repeated.
+      operands[n].value=0;
+    }
+      else
+    if (relax_forward(asm_context)==1)
+    {
+      shortened=1;
+    }
+  }
+
+  // Instructions like mov and bset only have the direct form so
+  // nothing was saved.
+  if (shortened==1 && has_extended(instr)) { relax_shortened(asm_context); }
+}
+
 int parse_instruction_68hc08(struct _asm_context *asm_context, char *instr)
 {
 char token[TOKENLEN];
@@ -172,6 +296,11 @@ int n;
 
   // Done parsing, now assemble.
 
+  if (asm_context->relax.enabled==1)
+  {
+    get_address_forms(asm_context, instr_case, operands, operand_count);
+  }
+
 #if 0
 printf("---------- %s operand_count=%d\n", instr, operand_count);
 for (n=0; n<operand_count; n++)
@@ -246,7 +375,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
           else
         if (m68hc08_table[n].operand_type==CPU08_OP_OPR8 &&
             operands[0].type==OPERAND_ADDRESS &&
-            operands[0].value<=0xff)
+            is_direct(&operands[0]))
         {
           if (size!=-1)
           {
@@ -287,8 +416,8 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
         if (m68hc08_table[n].operand_type==CPU08_OP_OPR8_OPR8 &&
             operands[0].type==OPERAND_ADDRESS &&
             operands[1].type==OPERAND_ADDRESS &&
-            operands[0].value <= 0xff &&
-            operands[1].value <= 0xff)
+            is_direct(&operands[0]) &&
+            is_direct(&operands[1]))
         {
           add_bin8(asm_context, n, IS_OPCODE);
           add_bin8(asm_context, operands[0].value, IS_OPCODE);
@@ -299,7 +428,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
         if (m68hc08_table[n].operand_type==CPU08_OP_NUM8_OPR8 &&
             operands[0].type==OPERAND_NUM8 &&
             operands[1].type==OPERAND_ADDRESS &&
-            operands[1].value <= 0xff)
+            is_direct(&operands[1]))
         {
           add_bin8(asm_context, n, IS_OPCODE);
           add_bin8(asm_context, operands[0].value, IS_OPCODE);
@@ -338,7 +467,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
           else
         if (m68hc08_table[n].operand_type==CPU08_OP_OPR8_X &&
             operands[0].type==OPERAND_ADDRESS &&
-            operands[0].value<=0xff &&
+            is_direct(&operands[0]) &&
             operands[1].type==OPERAND_X)
         {
           if (size!=-1)
@@ -354,7 +483,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
           else
         if (m68hc08_table[n].operand_type==CPU08_OP_OPR8_X_PLUS &&
             operands[0].type==OPERAND_ADDRESS &&
-            operands[0].value<=0xff &&
+            is_direct(&operands[0]) &&
             operands[1].type==OPERAND_X_PLUS)
         {
           if (size!=-1)
@@ -370,7 +499,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
           else
         if (m68hc08_table[n].operand_type==CPU08_OP_OPR8_REL &&
             operands[0].type==OPERAND_ADDRESS &&
-            operands[0].value<=0xff &&
+            is_direct(&operands[0]) &&
             operands[1].type==OPERAND_ADDRESS)
         {
           if (asm_context->pass==1) { operands[1].value=asm_context->address; }
@@ -399,7 +528,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
             operands[0].value>=0 &&
             operands[0].value<=7 &&
             operands[1].type==OPERAND_ADDRESS &&
-            operands[1].value<=0xff)
+            is_direct(&operands[1]))
         {
           add_bin8(asm_context, n, IS_OPCODE);
           add_bin8(asm_context, operands[1].value, IS_OPCODE);
@@ -413,7 +542,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
             operands[0].type==OPERAND_NONE &&
             operands[1].type==OPERAND_X_PLUS &&
             operands[2].type==OPERAND_ADDRESS &&
-            operands[2].value<=0xff)
+            is_direct(&operands[2]))
         {
           add_bin8(asm_context, n, IS_OPCODE);
           add_bin8(asm_context, operands[2].value, IS_OPCODE);
@@ -422,7 +551,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
           else
         if (m68hc08_table[n].operand_type==CPU08_OP_OPR8_X_PLUS_REL &&
             operands[0].type==OPERAND_ADDRESS &&
-            operands[0].value<=0xff &&
+            is_direct(&operands[0]) &&
             operands[1].type==OPERAND_X_PLUS &&
             operands[2].type==OPERAND_ADDRESS)
         {
@@ -441,7 +570,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
           else
         if (m68hc08_table[n].operand_type==CPU08_OP_OPR8_X_REL &&
             operands[0].type==OPERAND_ADDRESS &&
-            operands[0].value<=0xff &&
+            is_direct(&operands[0]) &&
             operands[1].type==OPERAND_X &&
             operands[2].type==OPERAND_ADDRESS)
         {
@@ -497,7 +626,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
             operands[0].value>=0 &&
             operands[0].value<=7 &&
             operands[1].type==OPERAND_ADDRESS &&
-            operands[1].value<=0xff &&
+            is_direct(&operands[1]) &&
             operands[2].type==OPERAND_ADDRESS)
         {
           if (asm_context->pass==1) { operands[2].value=asm_context->address; }
@@ -553,7 +682,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
           else
         if (m68hc08_16_table[n].operand_type==CPU08_OP_OPR8_SP &&
             operands[0].type==OPERAND_ADDRESS &&
-            operands[0].value<=0xff &&
+            is_direct(&operands[0]) &&
             operands[1].type==OPERAND_SP)
         {
           if (size!=-1)
@@ -573,7 +702,7 @@ printf("%04x %d\n", operands[n].value, operands[n].type);
       {
         if (m68hc08_16_table[n].operand_type==CPU08_OP_OPR8_SP_REL &&
             operands[0].type==OPERAND_ADDRESS &&
-            operands[0].value<=0xff &&
+            is_direct(&operands[0]) &&
             operands[1].type==OPERAND_SP &&
             operands[2].type==OPERAND_ADDRESS)
         {
@@ -20,6 +20,7 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "table/8051.h"
 
 enum
@@ -39,6 +40,13 @@ enum
   OPERAND_BIT_ADDRESS,
 };
 
+// Forms jmp and call can be given.
+enum
+{
+  JUMP_SHORT,     // sjmp, ajmp or acall
+  JUMP_LONG,      // ljmp or lcall
+};
+
 struct _operand
 {
   int value;
@@ -213,6 +221,90 @@ static int get_address(struct _asm_context *asm_context, int *num, uint8_t *is_b
   return get_bit_address(asm_context, num, is_bit_address);
 }
 
+static int parse_jump(struct _asm_context *asm_context, char *instr, int is_call)
+{
+  char token[TOKENLEN];
+  int token_type;
+  int address;
+  int offset;
+  int in_block;
+  int in_range;
+  int wanted;
+  int known = 1;
+
+  if (eval_expression(asm_context, &address) != 0)
+  {
+    if (asm_context->pass == 1)
+    {
+      eat_operand(asm_context);
+      known = 0;
+      address = 0;
+    }
+      else
+    {
+      print_error_illegal_expression(instr, asm_context);
+      return -1;
+    }
+  }
+
+  token_type = tokens_get(asm_context, token, TOKENLEN);
+
+  if (token_type != TOKEN_EOL && token_type != TOKEN_EOF)
+  {
+    print_error_unexp(token, asm_context);
+    return -1;
+  }
+
+  if (address < 0 || address > 0xffff)
+  {
+    print_error_range("Address", 0, 0xffff, asm_context);
+    return -1;
+  }
+
+  // sjmp is relative to the next instruction and ajmp/acall replace the
+  // low 11 bits of it, so both only reach from there.
+  offset = address - (asm_context->address + 2);
+  in_range = (is_call == 0 && offset >= -128 && offset <= 127);
+  in_block = ((asm_context->address + 2) & 0xf800) == (address & 0xf800);
+
+  if (known == 0)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  {
+    wanted = (in_range || in_block) ? JUMP_SHORT : JUMP_LONG;
+  }
+
+  if (relax_form(asm_context, wanted) == JUMP_LONG)
+  {
+    memory_write_inc(asm_context, is_call ? 0x12 : 0x02, asm_context->line);
+    memory_write_inc(asm_context, address >> 8, asm_context->line);
+    memory_write_inc(asm_context, address & 0xff, asm_context->line);
+
+    return 3;
+  }
+
+  if (in_range)
+  {
+    memory_write_inc(asm_context, 0x80, asm_context->line);
+    memory_write_inc(asm_context, (uint8_t)offset, asm_context->line);
+  }
+    else
+  {
+    if (asm_context->pass == 2 && in_block == 0)
+    {
+      print_error_internal(asm_context, __FILE__, __LINE__);
+      return -1;
+    }
+
+    memory_write_inc(asm_context, (((address >> 8) & 0x7) << 5) | (is_call ? 0x11 : 0x01), asm_context->line);
+    memory_write_inc(asm_context, address & 0xff, asm_context->line);
+  }
+
+  return 2;
+}
+
 int parse_instruction_8051(struct _asm_context *asm_context, char *instr)
 {
   char instr_case_mem[TOKENLEN];
@@ -229,6 +321,18 @@ int parse_instruction_8051(struct _asm_context *asm_context, char *instr)
   lower_copy(instr_case, instr);
   memset(&operands, 0, sizeof(operands));
 
+  // jmp and call to an address use the smallest form that reaches.
+  if (strcmp(instr_case, "jmp") == 0 || strcmp(instr_case, "call") == 0)
+  {
+    token_type = tokens_get(asm_context, token, TOKENLEN);
+    tokens_push(asm_context, token, token_type);
+
+    if (IS_NOT_TOKEN(token, '@'))
+    {
+      return parse_jump(asm_context, instr, instr_case[0] == 'c');
+    }
+  }
+
   while(1)
   {
     token_type = tokens_get(asm_context, token, TOKENLEN);
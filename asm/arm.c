@@ -19,6 +19,7 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/literals.h"
 #include "disasm/arm.h"
 #include "table/arm.h"
 
@@ -54,6 +55,7 @@ enum
   OPERAND_IMM_INDEXED_CLOSE,
   OPERAND_SHIFT_IMM_INDEXED_CLOSE,
   OPERAND_SHIFT_REG_INDEXED_CLOSE,
+  OPERAND_LITERAL,
 };
 
 struct _operand
@@ -378,6 +380,64 @@ static int parse_branch_exchange(struct _asm_context *asm_context, struct _opera
   return 4;
 }
 
+static int parse_ldr_literal(struct _asm_context *asm_context, struct _operand *operands, int cond)
+{
+  uint32_t value = operands[1].value;
+  uint32_t address;
+  int rd = operands[0].value;
+  int immediate;
+  int offset;
+  int u = 1;
+
+  // ldr rd, =value is a single mov or mvn when the value can be built
+  // from a rotated 8 bit immediate.  Values that aren't known in pass 1
+  // take a word in the literal pool which pass 2 leaves unused if it
+  // turns out they fit.
+  if (operands[1].sub_type == 0)
+  {
+    immediate = compute_immediate(value);
+
+    if (immediate != -1)
+    {
+      add_bin32(asm_context, 0x03a00000 | (cond << 28) | (rd << 12) | immediate, IS_OPCODE);
+      return 4;
+    }
+
+    immediate = compute_immediate(~value);
+
+    if (immediate != -1)
+    {
+      add_bin32(asm_context, 0x03e00000 | (cond << 28) | (rd << 12) | immediate, IS_OPCODE);
+      return 4;
+    }
+  }
+
+  if (literals_add(asm_context, value, operands[1].sub_type == 0, &address) != 0)
+  {
+    return -1;
+  }
+
+  offset = 0;
+
+  if (asm_context->pass == 2)
+  {
+    offset = address - (asm_context->address + 8);
+
+    if (offset < -4095 || offset > 4095)
+    {
+      print_error("Literal pool out of range (add a .ltorg)", asm_context);
+      return -1;
+    }
+
+    if (offset < 0) { offset = -offset; u = 0; }
+  }
+
+  // ldr rd, [pc, #offset]
+  add_bin32(asm_context, 0x051f0000 | (cond << 28) | (u << 23) | (rd << 12) | offset, IS_OPCODE);
+
+  return 4;
+}
+
 static int parse_ldr_str(struct _asm_context *asm_context, struct _operand *operands, int operand_count, char *instr, uint32_t opcode)
 {
   int offset = 0;
@@ -404,6 +464,19 @@ printf("%d  %d %d %d\n",
     return -1;
   }
 
+  if (operand_count == 2 &&
+      operands[0].type == OPERAND_REG &&
+      operands[1].type == OPERAND_LITERAL)
+  {
+    // ldr rd, =value
+    if ((opcode & (1 << 20)) == 0 || b == 1)
+    {
+      return ARM_ILLEGAL_OPERANDS;
+    }
+
+    return parse_ldr_literal(asm_context, operands, cond);
+  }
+    else
   if (operand_count == 2 &&
       operands[0].type == OPERAND_REG &&
       operands[1].type == OPERAND_NUMBER)
@@ -778,6 +851,17 @@ static int parse_multiply(struct _asm_context *asm_context, struct _operand *ope
   return 4;
 }
 
+int parse_directive_arm(struct _asm_context *asm_context, const char *directive)
+{
+  if (strcasecmp(directive, "ltorg") == 0 || strcasecmp(directive, "pool") == 0)
+  {
+    if (literals_flush(asm_context) != 0) { return -1; }
+    return 0;
+  }
+
+  return 1;
+}
+
 int parse_instruction_arm(struct _asm_context *asm_context, char *instr)
 {
   struct _operand operands[4];
@@ -864,6 +948,30 @@ int parse_instruction_arm(struct _asm_context *asm_context, char *instr)
       }
     }
       else
+    if (IS_TOKEN(token,'='))
+    {
+      int num;
+      operands[operand_count].type = OPERAND_LITERAL;
+
+      // sub_type is set when the value isn't known yet.
+      if (eval_expression(asm_context, &num) != 0)
+      {
+        if (asm_context->pass == 1)
+        {
+          eat_operand(asm_context);
+          operands[operand_count].sub_type = 1;
+          num = 0;
+        }
+          else
+        {
+          print_error_unexp(token, asm_context);
+          return -1;
+        }
+      }
+
+      operands[operand_count].value = num;
+    }
+      else
     if (IS_TOKEN(token,'['))
     {
       operands[operand_count].type = OPERAND_REG_INDEXED_OPEN;
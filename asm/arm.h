@@ -14,6 +14,7 @@
 
 #include "common/assembler.h"
 
+int parse_directive_arm(struct _asm_context *asm_context, const char *directive);
 int parse_instruction_arm(struct _asm_context *asm_context, char *instr);
 
 #endif
@@ -86,6 +86,73 @@ int r;
 }
 #endif
 
+static int get_relative_offset(struct _asm_context *asm_context, int address)
+{
+  int offset = address - ((asm_context->address / 2) + 1);
+  int words = asm_context->extra_context;
+
+  // The program counter wraps around on a part with a small flash so
+  // rjmp/rcall can reach the other end going the other way.
+  if (words != 0)
+  {
+    offset &= words - 1;
+    if (offset >= words / 2) { offset -= words; }
+  }
+
+  return offset;
+}
+
+static int parse_jump_relax(struct _asm_context *asm_context, char *instr, int address, int known)
+{
+  int offset = get_relative_offset(asm_context, address);
+  int opcode = instr[0] == 'c' ? 0xd000 : 0xc000;
+  int form;
+
+  // Form 0 is rjmp/rcall, form 1 is the 2 word jmp/call.
+  if (known == 0) { form = RELAX_UNKNOWN; }
+  else { form = (offset < -2048 || offset > 2047) ? 1 : 0; }
+
+  if (relax_form(asm_context, form) != 0) { return 0; }
+
+  if (asm_context->pass == 2 && (offset < -2048 || offset > 2047))
+  {
+    print_error_range("Offset", -2048, 2047, asm_context);
+    return -1;
+  }
+
+  relax_shortened(asm_context);
+
+  add_bin16(asm_context, opcode | (offset & 0xfff), IS_OPCODE);
+
+  return 2;
+}
+
+int parse_directive_avr8(struct _asm_context *asm_context, const char *directive)
+{
+  int num;
+
+  if (strcasecmp(directive, "flash_size") == 0)
+  {
+    if (eval_expression(asm_context, &num) != 0)
+    {
+      print_error("flash_size expects a size in bytes", asm_context);
+      return -1;
+    }
+
+    if (num < 2 || (num & (num - 1)) != 0)
+    {
+      print_error("flash_size must be a power of 2", asm_context);
+      return -1;
+    }
+
+    asm_context->extra_context = num / 2;
+
+    return 0;
+  }
+
+  return 1;
+}
+
 int parse_instruction_avr8(struct _asm_context *asm_context, char *instr)
 {
 char token[TOKENLEN];
@@ -98,6 +165,7 @@ int matched = 0;
 int offset;
 int n,num;
 int rd,rr,k;
+int known = 1;
 
   lower_copy(instr_case, instr);
 
@@ -248,6 +316,8 @@ int rd,rr,k;
         if (asm_context->pass == 1)
         {
           eat_operand(asm_context);
+          known = 0;
+          num = 0;
         }
           else
         {
@@ -297,6 +367,17 @@ int rd,rr,k;
     instr_case = "andi";
   }
 
+  // With .relax, jmp and call are shortened to rjmp and rcall whenever
+  // the target is close enough.
+  if (asm_context->relax.enabled == 1 &&
+      operand_count == 1 && operands[0].type == OPERAND_NUMBER &&
+      (strcmp(instr_case, "jmp") == 0 || strcmp(instr_case, "call") == 0))
+  {
+    int ret = parse_jump_relax(asm_context, instr_case, operands[0].value, known);
+
+    if (ret != 0) { return ret; }
+  }
+
   n = 0;
   while(table_avr8[n].instr != NULL)
   {
@@ -526,7 +607,7 @@ int rd,rr,k;
           if (operand_count == 1 && operands[0].type == OPERAND_NUMBER)
           {
             if (asm_context->pass == 1) { offset = 0; }
-            else { offset = operands[0].value - ((asm_context->address / 2) + 1); }
+            else { offset = get_relative_offset(asm_context, operands[0].value); }
 
             if (offset < -2048 || offset > 2047)
             {
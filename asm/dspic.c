@@ -20,6 +20,7 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "disasm/dspic.h"
 #include "table/dspic.h"
 
@@ -495,6 +496,51 @@ int xx = 0, yy = 0, iiii = 4, jjjj = 4, mmm = 0, aa = 2;
   return opcode;
 }
 
+static int parse_jump_relax(struct _asm_context *asm_context, char *instr, int address, int known)
+{
+  int is_call = strcmp(instr, "rcall") == 0 || strcmp(instr, "call") == 0;
+  int is_long = strcmp(instr, "goto") == 0 || strcmp(instr, "call") == 0;
+  int offset = address - ((asm_context->address / 2) + 2);
+  int fits = (offset & 1) == 0 && offset >= -32768 * 2 && offset <= 32767 * 2;
+  int form;
+
+  // Form 0 is bra/rcall, form 1 is the 2 word goto/call.
+  if (known == 0) { form = RELAX_UNKNOWN; }
+  else { form = fits == 1 ? 0 : 1; }
+
+  form = relax_form(asm_context, form);
+
+  if (form == 0)
+  {
+    if (asm_context->pass == 2 && fits == 0)
+    {
+      print_error_range("Offset", -32768 * 2, 32767 * 2, asm_context);
+      return -1;
+    }
+
+    if (is_long == 1)
+    {
+      relax_shortened(asm_context);
+      relax_saved(asm_context, 1);
+    }
+
+    add_bin32(asm_context, (is_call == 1 ? 0x070000 : 0x370000) | ((offset / 2) & 0xffff), IS_OPCODE);
+
+    return 4;
+  }
+
+  if (asm_context->pass == 2 &&
+      check_range(asm_context, "Address", address, 0, 0x7ffffe) == -1)
+  {
+    return -1;
+  }
+
+  add_bin32(asm_context, (is_call == 1 ? 0x020000 : 0x040000) | (address & 0xffff), IS_OPCODE);
+  add_bin32(asm_context, address >> 16, IS_OPCODE);
+
+  return 8;
+}
+
 int parse_instruction_dspic(struct _asm_context *asm_context, char *instr)
 {
   struct _operand operands[7];
@@ -505,6 +551,7 @@ int parse_instruction_dspic(struct _asm_context *asm_context, char *instr)
   int token_type;
   int matched;
   int opcode = 0;
+  int known = 1;
   int num;
   int n;
 
@@ -786,6 +833,7 @@ int parse_instruction_dspic(struct _asm_context *asm_context, char *instr)
           if (asm_context->pass == 1)
           {
             eat_operand(asm_context);
+            known = 0;
           }
             else
           {
@@ -822,6 +870,18 @@ int parse_instruction_dspic(struct _asm_context *asm_context, char *instr)
   }
 #endif
 
+  // bra and rcall grow into goto and call when the target is out of
+  // reach.  With .relax goto and call are also shortened to bra and rcall
+  // whenever the target is close enough.
+  if (operand_count == 1 && operands[0].type == OPTYPE_NUM &&
+      flag == FLAG_NONE &&
+      (strcmp(instr_case, "bra") == 0 || strcmp(instr_case, "rcall") == 0 ||
+       (asm_context->relax.enabled == 1 &&
+       (strcmp(instr_case, "goto") == 0 || strcmp(instr_case, "call") == 0))))
+  {
+    return parse_jump_relax(asm_context, instr_case, operands[0].value, known);
+  }
+
   // On pass 1 only calculate address.
   if (asm_context->pass == 1)
   {
@@ -18,6 +18,7 @@
 #include "asm/epiphany.h"
 #include "common/assembler.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "common/tokens.h"
 #include "disasm/epiphany.h"
 #include "table/epiphany.h"
@@ -34,12 +35,18 @@ enum
   OPERAND_INDEX_REG_REG,
 };
 
+enum
+{
+  FORM_16,
+  FORM_32,
+};
+
 struct _operand
 {
   uint8_t type;
   uint8_t reg;
   int value;
-  uint8_t use_32_bit_instruction;
+  uint8_t unknown;
   uint8_t reg_is_negative;
 };
 
@@ -118,6 +125,41 @@ static uint32_t get_reg_combo32(int a, int b, int c)
   return reg_combo;
 }
 
+static int get_form(struct _asm_context *asm_context, struct _operand *operand, int is_branch, int fits)
+{
+  int wanted;
+  int form;
+
+  // A label further down in the file is only known once pass 1 is
+  // repeated.  Branches always wait for it, immediates only with .relax.
+  if (operand->unknown == 1)
+  {
+    if (is_branch == 1 || asm_context->relax.enabled == 1)
+    {
+      wanted = RELAX_UNKNOWN;
+    }
+      else
+    {
+      wanted = FORM_32;
+    }
+  }
+    else
+  {
+    wanted = fits == 1 ? FORM_16 : FORM_32;
+  }
+
+  // Each 16 bit candidate is a relax site so pass 2 picks the same size
+  // as the final pass 1.
+  form = relax_form(asm_context, wanted);
+
+  if (form == FORM_16 && relax_forward(asm_context) == 1)
+  {
+    relax_shortened(asm_context);
+  }
+
+  return form;
+}
+
 int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
 {
   char instr_case[TOKENLEN];
@@ -198,8 +240,8 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
         if (asm_context->pass == 1)
         {
           eat_operand(asm_context);
-          memory_write(asm_context, asm_context->address, 1, asm_context->line);
-          operands[operand_count].use_32_bit_instruction = 1;
+          operands[operand_count].unknown = 1;
+          n = 0;
         }
           else
         {
@@ -208,11 +250,6 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
         }
       }
 
-      if (memory_read(asm_context, asm_context->address) != 0)
-      {
-        operands[operand_count].use_32_bit_instruction = 1;
-      }
-
       operands[operand_count].type = OPERAND_NUMBER;
       operands[operand_count].value = n;
     }
@@ -244,8 +281,8 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
             if (asm_context->pass == 1)
             {
               eat_operand(asm_context);
-              memory_write(asm_context, asm_context->address, 1, asm_context->line);
-              operands[operand_count].use_32_bit_instruction = 1;
+              operands[operand_count].unknown = 1;
+              n = 0;
             }
               else
             {
@@ -254,11 +291,6 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
             }
           }
 
-          if (memory_read(asm_context, asm_context->address) != 0)
-          {
-            operands[operand_count].use_32_bit_instruction = 1;
-          }
-
           operands[operand_count].type = OPERAND_INDEX_REG_IMM;
           operands[operand_count].value = n;
         }
@@ -311,8 +343,8 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
         if (asm_context->pass == 1)
         {
           eat_operand(asm_context);
-          memory_write(asm_context, asm_context->address, 1, asm_context->line);
-          operands[operand_count].use_32_bit_instruction = 1;
+          operands[operand_count].unknown = 1;
+          n = 0;
         }
           else
         {
@@ -321,11 +353,6 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
         }
       }
 
-      if (memory_read(asm_context, asm_context->address) != 0)
-      {
-        operands[operand_count].use_32_bit_instruction = 1;
-      }
-
       operands[operand_count].type = OPERAND_ADDRESS;
       operands[operand_count].value = n;
     }
@@ -352,23 +379,31 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
         {
           if (operand_count == 1 && operands[0].type == OPERAND_ADDRESS)
           {
-            if (operands[0].use_32_bit_instruction == 1) { break; }
-
             offset = operands[0].value - asm_context->address;
 
+            if (get_form(asm_context, &operands[0], 1, offset >= -256 && offset <= 255) == FORM_32)
+            {
+              break;
+            }
+
+            // Not known yet on this pass so the offset is a placeholder.
+            if (operands[0].unknown == 1) { offset = 0; }
+
             if ((offset & 1) != 0)
             {
               print_error("Address not on an odd boundary", asm_context);
               return -1;
             }
 
-            if (offset >= -256 && offset <= 255)
+            if (check_range(asm_context, "Offset", offset, -256, 255) == -1)
             {
-              offset = offset >> 1;
-
-              add_bin16(asm_context, table_epiphany[n].opcode | (((uint8_t)offset) << 8), IS_OPCODE);
-              return 2;
+              return -1;
             }
+
+            offset = offset >> 1;
+
+            add_bin16(asm_context, table_epiphany[n].opcode | (((uint8_t)offset) << 8), IS_OPCODE);
+            return 2;
           }
           break;
         }
@@ -378,6 +413,8 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
           {
             offset = operands[0].value - asm_context->address;
 
+            if (operands[0].unknown == 1) { offset = 0; }
+
             if ((offset & 1) != 0)
             {
               print_error("Address not on an odd boundary", asm_context);
@@ -403,11 +440,15 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
               operands[0].type == OPERAND_REG &&
               operands[1].type == OPERAND_INDEX_REG_IMM)
           {
-            if (operands[1].use_32_bit_instruction == 1) { break; }
-            if (operands[1].value < 0 || operands[1].value > 7) { break; }
             if (operands[0].reg > 7) { break; }
             if (operands[1].reg > 7) { break; }
 
+            if (get_form(asm_context, &operands[1], 0,
+                  operands[1].value >= 0 && operands[1].value <= 7) == FORM_32)
+            {
+              break;
+            }
+
             reg_combo = get_reg_combo16(operands[0].reg, operands[1].reg, 0);
 
             add_bin16(asm_context, table_epiphany[n].opcode | reg_combo | (operands[1].value << 7), IS_OPCODE);
@@ -516,7 +557,7 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
               operands[1].value == 0 &&
               operands[2].type == OPERAND_NUMBER)
           {
-            if (check_range(asm_context, "Immediate", operands[1].value, -2047, 2047) == -1) { return -1; }
+            if (check_range(asm_context, "Immediate", operands[2].value, -2047, 2047) == -1) { return -1; }
 
             if (operands[2].value < 0)
             {
@@ -543,9 +584,13 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
               operands[0].type == OPERAND_REG &&
               operands[1].type == OPERAND_NUMBER)
           {
-            if (operands[1].use_32_bit_instruction == 1) { break; }
             if (operands[0].reg > 7) { break; }
-            if (operands[1].value < 0 || operands[1].value > 0xff) { break; }
+
+            if (get_form(asm_context, &operands[1], 0,
+                  operands[1].value >= 0 && operands[1].value <= 0xff) == FORM_32)
+            {
+              break;
+            }
 
             reg_combo = get_reg_combo16(operands[0].reg, 0, 0);
             value = operands[1].value << 5;
@@ -568,7 +613,7 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
             value |= ((operands[1].value >> 8) & 0xff) << 20;
 
             add_bin32(asm_context, table_epiphany[n].opcode | reg_combo | value, IS_OPCODE);
-            return 2;
+            return 4;
           }
           break;
         }
@@ -579,10 +624,14 @@ int parse_instruction_epiphany(struct _asm_context *asm_context, char *instr)
               operands[1].type == OPERAND_REG &&
               operands[2].type == OPERAND_NUMBER)
           {
-            if (operands[1].use_32_bit_instruction == 1) { break; }
             if (operands[0].reg > 7) { break; }
             if (operands[1].reg > 7) { break; }
-            if (operands[2].value < -4 || operands[2].value > 3) { break; }
+
+            if (get_form(asm_context, &operands[2], 0,
+                  operands[2].value >= -4 && operands[2].value <= 3) == FORM_32)
+            {
+              break;
+            }
 
             reg_combo = get_reg_combo16(operands[0].reg, operands[1].reg, 0);
             value = (operands[2].value & 0x7) << 7;
@@ -49,6 +49,33 @@ struct _operand
   int field_mask;
 };
 
+// extra_context bits.
+#define MIPS_REORDER 1
+
+// li/la sizes.
+#define LI_SINGLE 0
+#define LI_PAIR 1
+
+enum
+{
+  SLOT_OTHER,
+  SLOT_MOVABLE,
+  SLOT_BRANCH,
+};
+
+// Instructions seen for filling delay slots with .set reorder.  The last
+// two are kept in asm_context->cpu_data.
+struct _slot_info
+{
+  int kind;
+  int address;
+  int count;
+  uint32_t reads;
+  uint32_t writes;
+  uint8_t in_delay_slot : 1;
+  uint8_t is_relative : 1;
+};
+
 static int get_number(char *s)
 {
   int n = 0;
@@ -499,11 +526,22 @@ static int check_for_pseudo_instruction(struct _asm_context *asm_context, struct
   return 4;
 }
 
+static int is_li_single(uint32_t value)
+{
+  if ((value & 0xffff) == value) { return 1; }
+  if ((value & 0xffff0000) == value) { return 1; }
+  if ((int32_t)value >= -32768 && (int32_t)value < 0) { return 1; }
+
+  return 0;
+}
+
 static int get_operands_li(struct _asm_context *asm_context, struct _operand *operands, char *instr, char *instr_case)
 {
   int operand_count = 0;
-  int optimize = 0;
+  int known = 1;
+  int form;
   uint32_t opcode;
+  uint32_t value;
   int num;
   int token_type;
   char token[TOKENLEN];
@@ -542,8 +580,7 @@ static int get_operands_li(struct _asm_context *asm_context, struct _operand *op
 
       eat_operand(asm_context);
 
-      //temp = var_get_int64(&var);
-
+      known = 0;
       num = 0;
     }
       else
@@ -558,41 +595,6 @@ static int get_operands_li(struct _asm_context *asm_context, struct _operand *op
       }
 
       num = temp;
-
-      if ((num & 0xffff) == num)
-      {
-        optimize = 1;
-      }
-        else
-      if ((num & 0xffff0000) == num)
-      {
-        optimize = 2;
-      }
-    }
-
-    if (asm_context->pass == 1)
-    {
-      add_bin32(asm_context, optimize, IS_OPCODE);
-
-      if (optimize == 0)
-      {
-        add_bin32(asm_context, 0, IS_OPCODE);
-        return 8;
-      }
-
-      return 4;
-    }
-      else
-    {
-#if 0
-      if (optimize != memory_read(asm_context, asm_context->address))
-      {
-        print_error_internal(asm_context, __FILE__, __LINE__);
-        exit(1);
-      }
-#endif
-
-      optimize = memory_read(asm_context, asm_context->address);
     }
 
     operands[1].type = OPERAND_IMMEDIATE;
@@ -606,31 +608,132 @@ static int get_operands_li(struct _asm_context *asm_context, struct _operand *op
     }
   } while(0);
 
-  if (optimize == 0)
+  value = operands[1].value;
+
+  // A single ori, addiu or lui if the value fits, otherwise lui and ori.
+  // Labels further down the file are sized by repeating pass 1.
+  if (known == 0) { form = RELAX_UNKNOWN; }
+  else if (is_li_single(value)) { form = LI_SINGLE; }
+  else { form = LI_PAIR; }
+
+  form = relax_form(asm_context, form);
+
+  if (form == LI_PAIR)
   {
     opcode = find_opcode("lui");
-    add_bin32(asm_context, opcode | (operands[0].value << 16) | ((operands[1].value >> 16) & 0xffff), IS_OPCODE);
+    add_bin32(asm_context, opcode | (operands[0].value << 16) | ((value >> 16) & 0xffff), IS_OPCODE);
 
     opcode = find_opcode("ori");
-    add_bin32(asm_context, opcode | (operands[0].value << 21) |(operands[0].value << 16) | (operands[1].value & 0xffff), IS_OPCODE);
+    add_bin32(asm_context, opcode | (operands[0].value << 21) | (operands[0].value << 16) | (value & 0xffff), IS_OPCODE);
 
     return 8;
   }
 
-  if (optimize == 1)
+  if (asm_context->pass == 2 && is_li_single(value) == 0)
+  {
+    print_error_internal(asm_context, __FILE__, __LINE__);
+    return -1;
+  }
+
+  if ((value & 0xffff) == value)
   {
     opcode = find_opcode("ori");
-    add_bin32(asm_context, opcode | (operands[0].value << 16) | (operands[1].value & 0xffff), IS_OPCODE);
   }
     else
+  if ((value & 0xffff0000) == value)
   {
     opcode = find_opcode("lui");
-    add_bin32(asm_context, opcode | (operands[0].value << 16) | ((operands[1].value >> 16) & 0xffff), IS_OPCODE);
+    value = value >> 16;
+  }
+    else
+  {
+    opcode = find_opcode("addiu");
   }
 
+  add_bin32(asm_context, opcode | (operands[0].value << 16) | (value & 0xffff), IS_OPCODE);
+
   return 4;
 }
 
+static int eval_operand(struct _asm_context *asm_context, int *num)
+{
+  char token[TOKENLEN];
+  int token_type;
+  int is_hi;
+
+  token_type = tokens_get(asm_context, token, TOKENLEN);
+
+  if (IS_NOT_TOKEN(token,'%'))
+  {
+    tokens_push(asm_context, token, token_type);
+    return eval_expression(asm_context, num);
+  }
+
+  // %hi(value) and %lo(value) split a 32 bit value for lui plus an
+  // addiu or load/store offset.  %lo is sign extended by the CPU so
+  // %hi is rounded up when bit 15 is set.
+  token_type = tokens_get(asm_context, token, TOKENLEN);
+
+  if (strcasecmp(token, "hi") == 0) { is_hi = 1; }
+  else if (strcasecmp(token, "lo") == 0) { is_hi = 0; }
+  else
+  {
+    print_error_unexp(token, asm_context);
+    return -1;
+  }
+
+  if (expect_token(asm_context, '(') != 0) { return -1; }
+  if (eval_expression(asm_context, num) != 0) { return -1; }
+  if (expect_token(asm_context, ')') != 0) { return -1; }
+
+  if (is_hi == 1)
+  {
+    *num = (((uint32_t)*num + 0x8000) >> 16) & 0xffff;
+  }
+    else
+  {
+    *num = (int16_t)(*num & 0xffff);
+  }
+
+  return 0;
+}
+
+static void eat_operand_base(struct _asm_context *asm_context, struct _operand *operand)
+{
+  char token[TOKENLEN];
+  int token_type;
+  int num;
+
+  // Skip an offset that isn't known yet but keep the base register of
+  // offset(base) so pass 1 knows which registers are used.
+  while(1)
+  {
+    token_type = tokens_get(asm_context, token, TOKENLEN);
+
+    if (IS_TOKEN(token,',') || token_type == TOKEN_EOL || token_type == TOKEN_EOF)
+    {
+      tokens_push(asm_context, token, token_type);
+      return;
+    }
+
+    if (IS_TOKEN(token,'('))
+    {
+      token_type = tokens_get(asm_context, token, TOKENLEN);
+      num = token[0] == '$' ? get_tregister(token) : -1;
+
+      if (num != -1)
+      {
+        operand->type = OPERAND_IMMEDIATE_RS;
+        operand->reg2 = num;
+      }
+        else
+      {
+        tokens_push(asm_context, token, token_type);
+      }
+    }
+  }
+}
+
 static int get_operands(struct _asm_context *asm_context, struct _operand *operands, char *instr, char *instr_case)
 {
   int operand_count = 0;
@@ -847,18 +950,18 @@ static int get_operands(struct _asm_context *asm_context, struct _operand *opera
 
       operands[operand_count].type = OPERAND_IMMEDIATE;
 
-      if (asm_context->pass == 1)
-      {
-        eat_operand(asm_context);
-        break;
-      }
-
       tokens_push(asm_context, token, token_type);
 
-      if (eval_expression(asm_context, &num) != 0)
+      if (eval_operand(asm_context, &num) != 0)
       {
-        print_error_unexp(token, asm_context);
-        return -1;
+        if (asm_context->pass == 2)
+        {
+          print_error_unexp(token, asm_context);
+          return -1;
+        }
+
+        eat_operand_base(asm_context, &operands[operand_count]);
+        break;
       }
 
       operands[operand_count].value = num;
@@ -932,6 +1035,269 @@ static int get_operands(struct _asm_context *asm_context, struct _operand *opera
   return operand_count;
 }
 
+static uint32_t get_register_mask(struct _operand *operand)
+{
+  // $0 is always zero so it never creates a dependency.
+  if (operand->type != OPERAND_TREG || operand->value == 0) { return 0; }
+
+  return (uint32_t)1 << operand->value;
+}
+
+static void get_slot_info(struct _asm_context *asm_context, struct _slot_info *slot, const char *instr_case, struct _operand *operands, int operand_count)
+{
+  const char *not_movable[] = { "break", "div", "divu", "jalr", "jr", "mfhi", "mflo", "mthi", "mtlo", NULL };
+  int n, r;
+
+  memset(slot, 0, sizeof(struct _slot_info));
+  slot->kind = SLOT_OTHER;
+  slot->address = asm_context->address;
+  slot->count = asm_context->instruction_count;
+
+  if (strcmp(instr_case, "j") == 0 || strcmp(instr_case, "jal") == 0)
+  {
+    slot->kind = SLOT_BRANCH;
+    if (instr_case[1] == 'a') { slot->writes = (uint32_t)1 << 31; }
+    return;
+  }
+
+  n = 0;
+  while(mips_r_table[n].instr != NULL)
+  {
+    if ((mips_r_table[n].version & asm_context->flags) != 0 &&
+        mips_r_table[n].operand_count == operand_count &&
+        strcmp(instr_case, mips_r_table[n].instr) == 0)
+    {
+      for (r = 0; r < operand_count; r++)
+      {
+        if (mips_r_table[n].operand[r] == MIPS_OP_RD)
+        {
+          slot->writes |= get_register_mask(&operands[r]);
+        }
+          else
+        if (mips_r_table[n].operand[r] == MIPS_OP_RS ||
+            mips_r_table[n].operand[r] == MIPS_OP_RT)
+        {
+          slot->reads |= get_register_mask(&operands[r]);
+        }
+      }
+
+      if (strcmp(instr_case, "jr") == 0 || strcmp(instr_case, "jalr") == 0)
+      {
+        slot->kind = SLOT_BRANCH;
+        return;
+      }
+
+      // HI/LO and traps aren't tracked so those instructions stay put.
+      for (r = 0; not_movable[r] != NULL; r++)
+      {
+        if (strcmp(instr_case, not_movable[r]) == 0) { return; }
+      }
+
+      slot->kind = SLOT_MOVABLE;
+      return;
+    }
+    n++;
+  }
+
+  n = 0;
+  while(mips_i_table[n].instr != NULL)
+  {
+    if ((mips_i_table[n].version & asm_context->flags) != 0 &&
+        mips_i_table[n].operand_count == operand_count &&
+        strcmp(instr_case, mips_i_table[n].instr) == 0)
+    {
+      if (mips_i_table[n].operand[0] != MIPS_OP_RT) { return; }
+
+      if (mips_i_table[n].operand[1] == MIPS_OP_RS ||
+          strcmp(instr_case, "lui") == 0)
+      {
+        slot->writes = get_register_mask(&operands[0]);
+        slot->reads = get_register_mask(&operands[1]);
+        slot->kind = SLOT_MOVABLE;
+      }
+        else
+      if (mips_i_table[n].operand[1] == MIPS_OP_IMMEDIATE_RS &&
+          instr_case[0] == 's' && strcmp(instr_case, "sc") != 0)
+      {
+        // Stores only read registers.  Loads are left alone since on
+        // MIPS I the loaded register isn't ready for the next instruction.
+        slot->reads = get_register_mask(&operands[0]);
+
+        if (operands[1].reg2 != 0)
+        {
+          slot->reads |= (uint32_t)1 << operands[1].reg2;
+        }
+
+        slot->kind = SLOT_MOVABLE;
+      }
+
+      return;
+    }
+    n++;
+  }
+
+  n = 0;
+  while(mips_branch_table[n].instr != NULL)
+  {
+    if ((mips_branch_table[n].version & asm_context->flags) != 0 &&
+        strcmp(instr_case, mips_branch_table[n].instr) == 0)
+    {
+      int len = strlen(instr_case);
+
+      // Branch likely annuls the delay slot when not taken.
+      if (instr_case[len - 1] == 'l' && instr_case[len - 2] != 'a') { return; }
+
+      slot->kind = SLOT_BRANCH;
+      slot->is_relative = 1;
+      slot->reads = get_register_mask(&operands[0]);
+
+      if (mips_branch_table[n].op_rt == -1)
+      {
+        slot->reads |= get_register_mask(&operands[1]);
+      }
+
+      if (strstr(instr_case, "al") != NULL)
+      {
+        slot->writes = (uint32_t)1 << 31;
+      }
+
+      return;
+    }
+    n++;
+  }
+}
+
+static void slot_history_free(void *data)
+{
+  free(data);
+}
+
+static struct _slot_info *get_slot_history(struct _asm_context *asm_context)
+{
+  struct _slot_info *slot_history;
+
+  slot_history = assembler_get_cpu_data(asm_context, slot_history_free);
+
+  if (slot_history == NULL)
+  {
+    slot_history = calloc(2, sizeof(struct _slot_info));
+    assembler_set_cpu_data(asm_context, slot_history, slot_history_free);
+  }
+
+  return slot_history;
+}
+
+static void add_slot_history(struct _asm_context *asm_context, struct _slot_info *slot)
+{
+  struct _slot_info *slot_history = get_slot_history(asm_context);
+  struct _slot_info *prev = &slot_history[1];
+
+  if (prev->kind == SLOT_BRANCH &&
+      prev->count + 1 == slot->count &&
+      prev->address + 4 == slot->address)
+  {
+    slot->in_delay_slot = 1;
+  }
+
+  slot_history[0] = slot_history[1];
+  slot_history[1] = *slot;
+}
+
+static int fill_delay_slot(struct _asm_context *asm_context)
+{
+  struct _memory *memory = &asm_context->memory;
+  struct _slot_info *slot_history = get_slot_history(asm_context);
+  struct _slot_info *mover = &slot_history[0];
+  struct _slot_info *branch = &slot_history[1];
+  uint32_t start[2], end[2];
+  uint32_t opcode;
+  int line;
+  int n;
+
+  if (mover->kind != SLOT_MOVABLE || branch->kind != SLOT_BRANCH) { return 0; }
+  if (mover->in_delay_slot == 1) { return 0; }
+
+  if (mover->count + 1 != branch->count ||
+      branch->count + 1 != asm_context->instruction_count ||
+      mover->address + 4 != branch->address ||
+      branch->address + 4 != asm_context->address)
+  {
+    return 0;
+  }
+
+  // A label after the mover could be jumped to directly, skipping it.
+  if (asm_context->label_address > mover->address) { return 0; }
+
+  if ((mover->writes & (branch->reads | branch->writes)) != 0 ||
+      (mover->reads & branch->writes) != 0)
+  {
+    return 0;
+  }
+
+  if (asm_context->pass == 2)
+  {
+    opcode = memory_read32_m(memory, branch->address);
+
+    if (branch->is_relative == 1)
+    {
+      // The branch moves up one word so its offset grows by one.
+      if ((opcode & 0xffff) == 0x7fff)
+      {
+        print_error_range("Offset", -(1 << 17), (1 << 17) - 1, asm_context);
+        return -1;
+      }
+
+      opcode = (opcode & 0xffff0000) | ((opcode + 1) & 0xffff);
+    }
+
+    memory_write32_m(memory, branch->address,
+      memory_read32_m(memory, mover->address));
+    memory_write32_m(memory, mover->address, opcode);
+
+    for (n = 0; n < 4; n++)
+    {
+      line = memory_debug_line_m(memory, mover->address + n);
+      memory_debug_line_set_m(memory, mover->address + n,
+        memory_debug_line_m(memory, branch->address + n));
+      memory_debug_line_set_m(memory, branch->address + n, line);
+    }
+
+    // Both lines were already listed, so list them again at their new
+    // addresses (the mover's line is now the delay slot).
+    start[0] = branch->address;
+    start[1] = mover->address;
+    end[0] = start[0] + 4;
+    end[1] = start[1] + 4;
+
+    if (listing_redo(asm_context, 2, start, end) != 0)
+    {
+      print_error("Couldn't update the listing for a delay slot", asm_context);
+      return -1;
+    }
+  }
+
+  relax_delay_slot(asm_context);
+
+  return 1;
+}
+
+int parse_directive_mips(struct _asm_context *asm_context, const char *directive)
+{
+  if (strcasecmp(directive, "reorder") == 0)
+  {
+    asm_context->extra_context |= MIPS_REORDER;
+    return 0;
+  }
+    else
+  if (strcasecmp(directive, "noreorder") == 0)
+  {
+    asm_context->extra_context &= ~MIPS_REORDER;
+    return 0;
+  }
+
+  return 1;
+}
+
 int parse_instruction_mips(struct _asm_context *asm_context, char *instr)
 {
   struct _operand operands[4];
@@ -941,13 +1307,18 @@ int parse_instruction_mips(struct _asm_context *asm_context, char *instr)
   uint32_t opcode;
   int opcode_size = 4;
   int found = 0;
+  int is_nop;
   int32_t offset;
+  struct _slot_info slot;
 
   lower_copy(instr_case, instr);
   memset(operands, 0, sizeof(operands));
 
   if (strcmp(instr_case, "li") == 0 || strcmp(instr_case, "la") == 0)
   {
+    get_slot_info(asm_context, &slot, instr_case, operands, 0);
+    add_slot_history(asm_context, &slot);
+
     return get_operands_li(asm_context, operands, instr, instr_case);
   }
     else
@@ -957,6 +1328,8 @@ int parse_instruction_mips(struct _asm_context *asm_context, char *instr)
 
   if (operand_count < 0) { return -1; }
 
+  is_nop = strcmp(instr_case, "nop") == 0 && operand_count == 0;
+
   n = check_for_pseudo_instruction(asm_context, operands, &operand_count, instr_case, instr);
 
   if (n != 4)
@@ -964,6 +1337,26 @@ int parse_instruction_mips(struct _asm_context *asm_context, char *instr)
     return opcode_size;
   }
 
+  get_slot_info(asm_context, &slot, instr_case, operands, operand_count);
+
+  // With .set reorder a nop after a branch is dropped when the instruction
+  // before the branch can be moved into the delay slot instead.
+  if (is_nop && (asm_context->extra_context & MIPS_REORDER) != 0)
+  {
+    n = fill_delay_slot(asm_context);
+
+    if (n == -1) { return -1; }
+
+    if (n == 1)
+    {
+      slot.kind = SLOT_OTHER;
+      add_slot_history(asm_context, &slot);
+      return 0;
+    }
+  }
+
+  add_slot_history(asm_context, &slot);
+
   if (asm_context->pass == 1)
   {
     add_bin32(asm_context, 0, IS_OPCODE);
@@ -17,10 +17,25 @@
 #include "asm/msp430.h"
 #include "common/assembler.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "common/tokens.h"
 #include "disasm/msp430.h"
 #include "table/msp430.h"
 
+// Forms an immediate can be relaxed to.
+enum
+{
+  IMMEDIATE_CG,         // constant generator, no extension word
+  IMMEDIATE_WORD,       // extension word
+};
+
+// Forms a jump can be relaxed to.
+enum
+{
+  JUMP_SHORT,           // j<cond> or jmp
+  JUMP_OVER_BR,         // j<!cond> over a br #address
+};
+
 enum
 {
   OPTYPE_ERROR,
@@ -40,6 +55,7 @@ struct _operand
   uint8_t type;  // OPTYPE
   uint8_t error; // if expression can't be evaluated on pass 1
   uint8_t mode;  // As or Ad
+  uint8_t written; // immediate was written with # (not from an alias)
 };
 
 struct _data
@@ -164,50 +180,95 @@ static int ignore_and_check_indexed(struct _asm_context *asm_context)
   }
 }
 
-static void operand_to_cg(struct _asm_context *asm_context, struct _operand *operand, int bw)
+static int operand_to_cg(struct _asm_context *asm_context, struct _operand *operand, int bw, int size)
 {
-  if (operand->type != OPTYPE_IMMEDIATE) { return; }
+  int value;
+  int wanted;
+  int form;
 
-  if (memory_read(asm_context, asm_context->address) == 1) { return; }
+  if (operand->type != OPTYPE_IMMEDIATE) { return 0; }
 
-  if (bw == 1 && operand->value == 0xff) { operand->value = -1; }
-  if (bw == 0 && operand->value == 0xffff) { operand->value = -1; }
+  value = operand->value;
 
-  switch(operand->value)
+  if (bw == 1 && value == 0xff) { value = -1; }
+  if (bw == 0 && size != 20 && value == 0xffff) { value = -1; }
+  if (size == 20 && value == 0xfffff) { value = -1; }
+
+  // R2 and R3 generate 0, 1, 2, 4, 8 and -1 without an extension word.
+  // A value that isn't known on pass 1 gets the extension word unless
+  // .relax is on, in which case pass 1 is repeated to find out.
+  if (operand->error == 1)
+  {
+    wanted = asm_context->relax.enabled == 1 ? RELAX_UNKNOWN : IMMEDIATE_WORD;
+  }
+    else
+  if (value == -1 || value == 0 || value == 1 ||
+      value == 2 || value == 4 || value == 8)
+  {
+    wanted = IMMEDIATE_CG;
+  }
+    else
+  {
+    wanted = IMMEDIATE_WORD;
+  }
+
+  form = relax_form(asm_context, wanted);
+
+  if (form == IMMEDIATE_WORD) { return 0; }
+
+  if (asm_context->pass == 2 && wanted != IMMEDIATE_CG)
+  {
+    print_error_internal(asm_context, __FILE__, __LINE__);
+    return -1;
+  }
+
+  switch(value)
   {
     case -1:
-      operand->type = OPTYPE_REGISTER;
       operand->mode = 3;
       operand->reg = 3;
       break;
     case 0:
-      operand->type = OPTYPE_REGISTER;
       operand->mode = 0;
       operand->reg = 3;
       break;
     case 1:
-      operand->type = OPTYPE_REGISTER;
       operand->mode = 1;
       operand->reg = 3;
       break;
     case 2:
-      operand->type = OPTYPE_REGISTER;
       operand->mode = 2;
       operand->reg = 3;
       break;
     case 4:
-      operand->type = OPTYPE_REGISTER;
       operand->mode = 2;
       operand->reg = 2;
       break;
     case 8:
-      operand->type = OPTYPE_REGISTER;
       operand->mode = 3;
       operand->reg = 2;
       break;
     default:
       break;
   }
+
+  operand->type = OPTYPE_REGISTER;
+  operand->value = value;
+
+  // With .relax every # immediate that didn't need an extension word is
+  // reported.
+  if (asm_context->relax.enabled == 1 && operand->written == 1)
+  {
+    relax_shortened(asm_context);
+
+    if (asm_context->pass == 2 && asm_context->quiet_output == 0)
+    {
+      printf("Note: #%d uses the constant generator at %s:%d.\n",
+        value, asm_context->filename, asm_context->line);
+    }
+  }
+
+  return 0;
 }
 
 static int process_operand(struct _asm_context *asm_context, struct _operand *operand, struct _data *data, const char *instr, int size, int is_src, int is_extended)
@@ -384,6 +445,123 @@ static uint16_t get_prefix(struct _asm_context *asm_context, int zc)
   return prefix;
 }
 
+static int is_jump(const char *instr_case)
+{
+  int n = 0;
+
+  while(table_msp430[n].instr != NULL)
+  {
+    if (table_msp430[n].type == OP_JUMP &&
+        strcmp(table_msp430[n].instr, instr_case) == 0)
+    {
+      return 1;
+    }
+
+    n++;
+  }
+
+  return 0;
+}
+
+static int parse_jump(struct _asm_context *asm_context, int address, int known, int opcode)
+{
+  int offset = address - (asm_context->address + 2);
+  int cond = (opcode >> 10) & 7;
+  int wanted;
+  int form;
+
+  // Pick the smallest form that reaches.  A jump that can't reach is
+  // changed to br #address and a conditional jump jumps over it with the
+  // condition inverted.
+  if (known == 0)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  if (offset >= -1024 && offset <= 1022)
+  {
+    wanted = JUMP_SHORT;
+  }
+    else
+  {
+    wanted = JUMP_OVER_BR;
+  }
+
+  form = relax_form(asm_context, wanted);
+
+  if (asm_context->pass == 1)
+  {
+    offset = 0;
+    address = asm_context->address;
+  }
+
+  if ((address & 1) == 1)
+  {
+    print_error("Jump offset is odd", asm_context);
+    return -1;
+  }
+
+  if (form == JUMP_SHORT)
+  {
+    if (offset < -1024 || offset > 1023)
+    {
+      print_error_range("Offset", -1024, 1022, asm_context);
+      return -1;
+    }
+
+    add_bin16(asm_context, opcode | ((offset >> 1) & 0x03ff), IS_OPCODE);
+
+    return 2;
+  }
+
+  if (asm_context->cpu_type == CPU_TYPE_MSP430X)
+  {
+    if (address < 0 || address > 0xfffff)
+    {
+      print_error_range("Address", 0, 0xfffff, asm_context);
+      return -1;
+    }
+  }
+    else
+  if (address < 0 || address > 0xffff)
+  {
+    print_error_range("Address", 0, 0xffff, asm_context);
+    return -1;
+  }
+
+  if (cond == 4)
+  {
+    // jn doesn't have an opposite so jn to the br and jmp over it.
+    add_bin16(asm_context, 0x3000 | 1, IS_OPCODE);
+    add_bin16(asm_context, 0x3c00 | 2, IS_OPCODE);
+  }
+    else
+  if (cond != 7)
+  {
+    // jnz/jz, jnc/jc and jge/jl are pairs.
+    cond = (cond < 4) ? (cond ^ 1) : (11 - cond);
+    add_bin16(asm_context, 0x2000 | (cond << 10) | 2, IS_OPCODE);
+  }
+
+  if (address > 0xffff)
+  {
+    // bra #address (mova #imm20, pc)
+    add_bin16(asm_context, 0x0080 | (((address >> 16) & 0xf) << 8), IS_OPCODE);
+  }
+    else
+  {
+    // br #address (mov #imm, pc)
+    add_bin16(asm_context, 0x4030, IS_OPCODE);
+  }
+
+  add_bin16(asm_context, address & 0xffff, IS_OPCODE);
+
+  if (cond == 4) { return 8; }
+  if (cond == 7) { return 4; }
+
+  return 6;
+}
+
 int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
 {
   struct _operand operands[3];
@@ -399,7 +577,7 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
   int opcode;
   //int msp430x = 0;
   int prefix = 0;
-  int offset, value, wa, reg;
+  int value, wa, reg;
   int count, found = 0;
 
   lower_copy(instr_case, instr);
@@ -499,6 +677,7 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
     if (IS_TOKEN(token,'#'))
     {
       operands[operand_count].type = OPTYPE_IMMEDIATE;
+      operands[operand_count].written = 1;
 
       if (eval_expression(asm_context, &num) != 0)
       {
@@ -506,10 +685,6 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
         {
           eat_operand(asm_context);
           operands[operand_count].error = 1;
-
-          // Store a flag in this address to remind on pass 2 that this
-          // instruction can't use CG.
-          memory_write(asm_context, asm_context->address, 1, asm_context->line);
         }
           else
         {
@@ -519,7 +694,6 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
       }
 
       operands[operand_count].value = num;
-      operands[operand_count].error = memory_read(asm_context, asm_context->address);
     }
       else
     if (IS_TOKEN(token,'@'))
@@ -580,6 +754,23 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
       {
         operands[operand_count].type = OPTYPE_SYMBOLIC;
 
+        if (asm_context->pass == 1 && is_jump(instr_case) == 1)
+        {
+          // Jumps need the address in pass 1 to pick their size.
+          int neg = 1;
+          if (IS_TOKEN(token,'-')) { neg = -1; }
+          else { tokens_push(asm_context, token, token_type); }
+
+          if (eval_expression(asm_context, &num) != 0)
+          {
+            eat_operand(asm_context);
+            operands[operand_count].error = 1;
+            num = 0;
+          }
+
+          operands[operand_count].value = num * neg;
+        }
+          else
         if (asm_context->pass == 1)
         {
           // In pass 1 it will always be 2 words long, so who cares
@@ -798,7 +989,10 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
           }
             else
           {
-            operand_to_cg(asm_context, &operands[0], bw);
+            if (operand_to_cg(asm_context, &operands[0], bw, size) != 0)
+            {
+              return -1;
+            }
           }
 
           opcode |= bw << 6;
@@ -831,42 +1025,13 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          if (asm_context->pass == 1)
-          {
-            offset = asm_context->address;
-          }
-            else
-          {
-            if (operands[0].type != OPTYPE_SYMBOLIC)
-            {
-              print_error("Expecting a branch address", asm_context);
-              return -1;
-            }
-
-            offset = operands[0].value;
-          }
-
-          if ((offset & 1) == 1)
-          {
-            print_error("Jump offset is odd", asm_context);
-            return -1;
-          }
-
-          offset = offset - (asm_context->address + 2);
-
-          if (offset < -1024 || offset > 1023)
+          if (asm_context->pass == 2 && operands[0].type != OPTYPE_SYMBOLIC)
           {
-            print_error_range("Offset", -1024, 1022, asm_context);
+            print_error("Expecting a branch address", asm_context);
             return -1;
           }
 
-          offset = offset >> 1;
-
-          opcode |= ((uint32_t)offset) & 0x03ff;
-
-          add_bin16(asm_context, opcode, IS_OPCODE);
-
-          return 2;
+          return parse_jump(asm_context, operands[0].value, operands[0].error == 0, opcode);
         case OP_TWO_OPERAND:
           if (operand_count != 2)
           {
@@ -874,7 +1039,10 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          operand_to_cg(asm_context, &operands[0], bw);
+          if (operand_to_cg(asm_context, &operands[0], bw, size) != 0)
+          {
+            return -1;
+          }
 
           opcode |= bw << 6;
 
@@ -1414,7 +1582,10 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
           }
             else
           {
-            operand_to_cg(asm_context, &operands[0], bw);
+            if (operand_to_cg(asm_context, &operands[0], bw, size) != 0)
+            {
+              return -1;
+            }
           }
 
           if (size == 8) { al = 1; bw = 1; }
@@ -1422,17 +1593,6 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
           else if (size == 20) { al = 0; bw = 1; }
           else { al = 1; bw = 0; }
 
-          if (size == 20 &&
-              operands[0].type == OPTYPE_IMMEDIATE &&
-              operands[0].value == 0xfffff &&
-              operands[0].error == 0)
-          {
-            operands[0].value = -1;
-            operands[0].type = OPTYPE_REGISTER;
-            operands[0].mode = 3;
-            operands[0].reg = 3;
-          }
-
           opcode |= bw << 6;
 
           if (process_operand(asm_context, &operands[0], &data, instr, size, 1, 1) != 0)
@@ -1467,24 +1627,16 @@ int parse_instruction_msp430(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          operand_to_cg(asm_context, &operands[0], bw);
+          if (operand_to_cg(asm_context, &operands[0], bw, size) != 0)
+          {
+            return -1;
+          }
 
           if (size == 8) { al = 1; bw = 1; }
           else if (size == 16) { al = 1; bw = 0; }
           else if (size == 20) { al = 0; bw = 1; }
           else { al = 1; bw = 0; }
 
-          if (size == 20 &&
-              operands[0].type == OPTYPE_IMMEDIATE &&
-              operands[0].value == 0xfffff &&
-              operands[0].error == 0)
-          {
-            operands[0].value = -1;
-            operands[0].type = OPTYPE_REGISTER;
-            operands[0].mode = 3;
-            operands[0].reg = 3;
-          }
-
           opcode |= bw << 6;
 
           if (process_operand(asm_context, &operands[0], &data, instr, size, 1, 1) != 0)
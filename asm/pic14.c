@@ -20,10 +20,22 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "table/pic14.h"
 
 #define MAX_OPERANDS 2
 
+#define STATUS 0x03
+#define PCLATH 0x0a
+
+// extra_context holds what .banktrack knows about RP0 and RP1.
+#define BANK_TRACK 0x01
+#define BANK_RP0_KNOWN 0x02
+#define BANK_RP0 0x04
+#define BANK_RP1_KNOWN 0x08
+#define BANK_RP1 0x10
+#define BANK_SKIP 0x20
+
 enum
 {
   OPERAND_NUMBER,
@@ -35,8 +47,199 @@ struct _operand
 {
   int value;
   int type;
+  int unknown;
 };
 
+int parse_directive_pic14(struct _asm_context *asm_context, const char *directive)
+{
+  if (strcasecmp(directive, "banktrack") == 0)
+  {
+    asm_context->extra_context = BANK_TRACK;
+    return 0;
+  }
+    else
+  if (strcasecmp(directive, "nobanktrack") == 0)
+  {
+    asm_context->extra_context = 0;
+    return 0;
+  }
+
+  return 1;
+}
+
+static int is_common_register(int value)
+{
+  // INDF, PCL, STATUS, FSR, PCLATH and INTCON are in every bank.
+  switch(value & 0x7f)
+  {
+    case 0x00:
+    case 0x02:
+    case 0x03:
+    case 0x04:
+    case 0x0a:
+    case 0x0b:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static int bit_changes(int state, int known, int bit, int value)
+{
+  if ((state & known) == 0) { return 1; }
+
+  return ((state & bit) != 0) != (value != 0);
+}
+
+static int get_bank_changes(struct _asm_context *asm_context, int bank)
+{
+  int state = asm_context->extra_context;
+
+  return bit_changes(state, BANK_RP0_KNOWN, BANK_RP0, bank & 1) +
+         bit_changes(state, BANK_RP1_KNOWN, BANK_RP1, bank & 2);
+}
+
+static int write_bank_select(struct _asm_context *asm_context, int bank, int count)
+{
+  int state = asm_context->extra_context;
+  int rp0 = bit_changes(state, BANK_RP0_KNOWN, BANK_RP0, bank & 1);
+  int rp1 = bit_changes(state, BANK_RP1_KNOWN, BANK_RP1, bank & 2);
+
+  // A site can have grown on an earlier pass, so use up the rest of it
+  // with a select that doesn't change anything.
+  count -= rp0 + rp1;
+  if (rp0 == 0 && count > 0) { rp0 = 1; count--; }
+  if (rp1 == 0 && count > 0) { rp1 = 1; count--; }
+
+  if (rp0 == 1)
+  {
+    add_bin16(asm_context, ((bank & 1) != 0 ? 0x1680 : 0x1280) | STATUS, IS_OPCODE);
+  }
+
+  if (rp1 == 1)
+  {
+    add_bin16(asm_context, ((bank & 2) != 0 ? 0x1700 : 0x1300) | STATUS, IS_OPCODE);
+  }
+
+  asm_context->extra_context = (state & BANK_TRACK) |
+    BANK_RP0_KNOWN | BANK_RP1_KNOWN |
+    ((bank & 1) != 0 ? BANK_RP0 : 0) |
+    ((bank & 2) != 0 ? BANK_RP1 : 0);
+
+  return (rp0 + rp1) * 2;
+}
+
+static int write_banksel(struct _asm_context *asm_context, struct _operand *operand)
+{
+  int bank = (operand->value >> 7) & 3;
+  int count = 2;
+  int wanted;
+
+  // Without .banktrack both RP0 and RP1 are always set.
+  if ((asm_context->extra_context & BANK_TRACK) != 0)
+  {
+    wanted = operand->unknown == 1 ?
+      RELAX_UNKNOWN : get_bank_changes(asm_context, bank);
+
+    count = relax_form(asm_context, wanted);
+
+    if (count < 2)
+    {
+      relax_shortened(asm_context);
+      relax_saved(asm_context, 2 - count);
+    }
+  }
+
+  return write_bank_select(asm_context, bank, count);
+}
+
+static int write_pagesel(struct _asm_context *asm_context, struct _operand *operand)
+{
+  int page = (operand->value >> 11) & 3;
+
+  add_bin16(asm_context, ((page & 1) != 0 ? 0x1580 : 0x1180) | PCLATH, IS_OPCODE);
+  add_bin16(asm_context, ((page & 2) != 0 ? 0x1600 : 0x1200) | PCLATH, IS_OPCODE);
+
+  return 4;
+}
+
+static int write_auto_bank(struct _asm_context *asm_context, struct _operand *operand)
+{
+  int bank = (operand->value >> 7) & 3;
+  int wanted, count;
+
+  if (operand->unknown == 1)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  if (operand->value < 0 || is_common_register(operand->value))
+  {
+    wanted = 0;
+  }
+    else
+  {
+    wanted = get_bank_changes(asm_context, bank);
+  }
+
+  count = relax_form(asm_context, wanted);
+
+  if (count == 0) { return 0; }
+
+  if (asm_context->pass == 2 &&
+      (asm_context->extra_context & BANK_SKIP) != 0)
+  {
+    print_error("Bank select needed after an instruction that can skip", asm_context);
+    return -1;
+  }
+
+  return write_bank_select(asm_context, bank, count);
+}
+
+static void update_bank_state(struct _asm_context *asm_context, int n, struct _operand *operands)
+{
+  int state = asm_context->extra_context & ~BANK_SKIP;
+  int type = table_pic14[n].type;
+  int is_status = (operands[0].value & 0x7f) == STATUS;
+
+  if (type == OP_F_B && is_status &&
+     (table_pic14[n].opcode == 0x1000 || table_pic14[n].opcode == 0x1400) &&
+     (operands[1].value == 5 || operands[1].value == 6))
+  {
+    // bcf / bsf STATUS, RP0 or RP1
+    int known = operands[1].value == 5 ? BANK_RP0_KNOWN : BANK_RP1_KNOWN;
+    int bit = operands[1].value == 5 ? BANK_RP0 : BANK_RP1;
+
+    state |= known;
+    if (table_pic14[n].opcode == 0x1400) { state |= bit; }
+    else { state &= ~bit; }
+  }
+    else
+  if ((type == OP_F || (type == OP_F_D && operands[1].type == OPERAND_F)) &&
+      is_status)
+  {
+    state &= BANK_TRACK;
+  }
+    else
+  if (type == OP_K11 ||
+      strcmp(table_pic14[n].instr, "return") == 0 ||
+      strcmp(table_pic14[n].instr, "retlw") == 0 ||
+      strcmp(table_pic14[n].instr, "retfie") == 0)
+  {
+    // A call can change the bank and the others leave straight-line code.
+    state &= BANK_TRACK;
+  }
+
+  // Only the skip instructions take 1 or 2 cycles.
+  if (type != OP_K11 &&
+      table_pic14[n].cycles_min != table_pic14[n].cycles_max)
+  {
+    state |= BANK_SKIP;
+  }
+
+  asm_context->extra_context = state;
+}
+
 int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
 {
   char instr_case_mem[TOKENLEN];
@@ -45,18 +248,38 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
   struct _operand operands[MAX_OPERANDS];
   int operand_count = 0;
   int token_type;
+  int tracking;
+  int count = 0;
   int num, n;
   uint16_t opcode;
 
-  if (asm_context->pass == 1)
+  lower_copy(instr_case, instr);
+  tracking = (asm_context->extra_context & BANK_TRACK) != 0;
+
+  // banksel and pagesel are always 2 instructions so unless .banktrack
+  // needs the operands nothing has to be known on pass 1.
+  if (asm_context->pass == 1 && tracking == 0)
   {
     ignore_line(asm_context);
 
+    if (strcmp(instr_case, "banksel") == 0 ||
+        strcmp(instr_case, "pagesel") == 0)
+    {
+      add_bin16(asm_context, 0, IS_OPCODE);
+      add_bin16(asm_context, 0, IS_OPCODE);
+      return 4;
+    }
+
     add_bin16(asm_context, 0, IS_OPCODE);
     return 2;
   }
 
-  lower_copy(instr_case, instr);
+  // Anything could jump to a label.
+  if (tracking == 1 && asm_context->label_address == asm_context->address)
+  {
+    asm_context->extra_context = BANK_TRACK;
+  }
+
   memset(&operands, 0, sizeof(operands));
 
   while(1)
@@ -90,8 +313,15 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
 
       if (eval_expression(asm_context, &num) != 0)
       {
-        print_error_unexp(token, asm_context);
-        return -1;
+        if (asm_context->pass == 2)
+        {
+          print_error_unexp(token, asm_context);
+          return -1;
+        }
+
+        eat_operand(asm_context);
+        operands[operand_count].unknown = 1;
+        num = 0;
       }
 
       operands[operand_count].value = num;
@@ -109,6 +339,29 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
     }
   }
 
+  if (strcmp(instr_case, "banksel") == 0 ||
+      strcmp(instr_case, "pagesel") == 0)
+  {
+    if (operand_count != 1)
+    {
+      print_error_opcount(instr, asm_context);
+      return -1;
+    }
+
+    if (operands[0].type != OPERAND_NUMBER)
+    {
+      print_error_illegal_operands(instr, asm_context);
+      return -1;
+    }
+
+    if (instr_case[0] == 'b')
+    {
+      return write_banksel(asm_context, &operands[0]);
+    }
+
+    return write_pagesel(asm_context, &operands[0]);
+  }
+
   n = 0;
   while(table_pic14[n].instr != NULL)
   {
@@ -124,9 +377,9 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          add_bin16(asm_context, table_pic14[n].opcode, IS_OPCODE);
+          opcode = table_pic14[n].opcode;
 
-          return 2;
+          break;
         }
         case OP_F_D:
         {
@@ -142,9 +395,9 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          if (operands[0].value < -64 || operands[0].value > 127)
+          if (operands[0].value < -64 || operands[0].value > 0x1ff)
           {
-            print_error_range("Literal", -64, 127, asm_context);
+            print_error_range("Literal", -64, 0x1ff, asm_context);
             return -1;
           }
 
@@ -152,18 +405,16 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
 
           if (operands[1].type == OPERAND_F)
           {
-            add_bin16(asm_context, opcode | 0x80, IS_OPCODE);
-            return 2;
+            opcode |= 0x80;
           }
-
-          if (operands[1].type == OPERAND_W)
+            else
+          if (operands[1].type != OPERAND_W)
           {
-            add_bin16(asm_context, opcode, IS_OPCODE);
-            return 2;
+            print_error_illegal_operands(instr, asm_context);
+            return -1;
           }
 
-          print_error_illegal_operands(instr, asm_context);
-          return -1;
+          break;
         }
         case OP_F:
         {
@@ -179,16 +430,15 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          if (operands[0].value < -64 || operands[0].value > 127)
+          if (operands[0].value < -64 || operands[0].value > 0x1ff)
           {
-            print_error_range("Literal", -64, 127, asm_context);
+            print_error_range("Literal", -64, 0x1ff, asm_context);
             return -1;
           }
 
           opcode = table_pic14[n].opcode | (operands[0].value & 0x7f);
-          add_bin16(asm_context, opcode, IS_OPCODE);
 
-          return 2;
+          break;
         }
         case OP_F_B:
         {
@@ -205,9 +455,9 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          if (operands[0].value < -64 || operands[0].value > 127)
+          if (operands[0].value < -64 || operands[0].value > 0x1ff)
           {
-            print_error_range("Literal", -64, 127, asm_context);
+            print_error_range("Literal", -64, 0x1ff, asm_context);
             return -1;
           }
 
@@ -220,9 +470,8 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
           opcode = table_pic14[n].opcode |
                   (operands[0].value & 0x7f) |
                   (operands[1].value << 7);
-          add_bin16(asm_context, opcode, IS_OPCODE);
 
-          return 2;
+          break;
         }
         case OP_K8:
         {
@@ -245,9 +494,8 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
           }
 
           opcode = table_pic14[n].opcode | (operands[0].value & 0xff);
-          add_bin16(asm_context, opcode, IS_OPCODE);
 
-          return 2;
+          break;
         }
         case OP_K11:
         {
@@ -263,20 +511,41 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          if (operands[0].value < -1024 || operands[0].value > 2047)
+          // The upper 2 bits of a page past the first come from PCLATH.
+          if (operands[0].value < -1024 || operands[0].value > 0x1fff)
           {
-            print_error_range("Literal", -1024, 2047, asm_context);
+            print_error_range("Literal", -1024, 0x1fff, asm_context);
             return -1;
           }
 
           opcode = table_pic14[n].opcode | (operands[0].value & 0x7ff);
-          add_bin16(asm_context, opcode, IS_OPCODE);
 
-          return 2;
+          break;
         }
         default:
-          break; 
+          print_error_internal(asm_context, __FILE__, __LINE__);
+          return -1;
       }
+
+      // With .banktrack registers outside the bank RP0 and RP1 are known
+      // to select get a bank select in front of them.
+      if (tracking == 1)
+      {
+        if (table_pic14[n].type == OP_F_D ||
+            table_pic14[n].type == OP_F ||
+            table_pic14[n].type == OP_F_B)
+        {
+          count = write_auto_bank(asm_context, &operands[0]);
+
+          if (count == -1) { return -1; }
+        }
+
+        update_bank_state(asm_context, n, operands);
+      }
+
+      add_bin16(asm_context, opcode, IS_OPCODE);
+
+      return count + 2;
     }
 
     n++;
@@ -286,5 +555,3 @@ int parse_instruction_pic14(struct _asm_context *asm_context, char *instr)
 
   return -1; 
 }
-
-
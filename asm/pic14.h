@@ -15,6 +15,7 @@
 #include "common/assembler.h"
 
 int parse_instruction_pic14(struct _asm_context *asm_context, char *instr);
+int parse_directive_pic14(struct _asm_context *asm_context, const char *directive);
 
 #endif
 
@@ -19,6 +19,7 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "table/powerpc.h"
 
 #define MAX_OPERANDS 5
@@ -34,11 +35,27 @@ enum
   OPERAND_REGISTER_OFFSET,
 };
 
+enum
+{
+  HALF_NONE,
+  HALF_LO,
+  HALF_HI,
+  HALF_HA,
+};
+
+enum
+{
+  BRANCH_SHORT,
+  BRANCH_INVERT,
+  BRANCH_SKIP,
+};
+
 struct _operand
 {
   int value;
   int type;
   int16_t offset;
+  uint8_t unknown;
 };
 
 struct _modifiers
@@ -87,11 +104,57 @@ static int get_spr_powerpc(char *token)
   return -1;
 }
 
+static int get_half(struct _asm_context *asm_context, int *value)
+{
+  char token[TOKENLEN];
+  int token_type;
+  int half;
+
+  // label@h, label@l and label@ha pick half of a 32 bit value for
+  // lis/addis followed by ori or addi (@ha makes up for addi sign
+  // extending the low half).
+  token_type = tokens_get(asm_context, token, TOKENLEN);
+
+  if (IS_NOT_TOKEN(token, '@'))
+  {
+    tokens_push(asm_context, token, token_type);
+    return HALF_NONE;
+  }
+
+  token_type = tokens_get(asm_context, token, TOKENLEN);
+
+  if (strcasecmp(token, "l") == 0)
+  {
+    *value = *value & 0xffff;
+    half = HALF_LO;
+  }
+    else
+  if (strcasecmp(token, "h") == 0)
+  {
+    *value = (*value >> 16) & 0xffff;
+    half = HALF_HI;
+  }
+    else
+  if (strcasecmp(token, "ha") == 0)
+  {
+    *value = (((uint32_t)*value + 0x8000) >> 16) & 0xffff;
+    half = HALF_HA;
+  }
+    else
+  {
+    print_error_unexp(token, asm_context);
+    return -1;
+  }
+
+  return half;
+}
+
 static int get_operands(struct _asm_context *asm_context, struct _operand *operands, char *instr, char *instr_case, struct _modifiers *modifiers)
 {
   char token[TOKENLEN];
   int token_type;
   int operand_count = 0;
+  int half;
   int n;
 
   while(1)
@@ -192,57 +255,66 @@ static int get_operands(struct _asm_context *asm_context, struct _operand *opera
       // Assume this is just a number
       operands[operand_count].type = OPERAND_NUMBER;
 
-      if (asm_context->pass == 1)
+      // Branch targets are needed on pass 1 so a label further down in
+      // the file is left as unknown instead.
+      tokens_push(asm_context, token, token_type);
+      if (eval_expression(asm_context, &n) != 0)
       {
-        eat_operand(asm_context);
-        operands[operand_count].value = 0;
+        if (asm_context->pass == 1)
+        {
+          eat_operand(asm_context);
+          operands[operand_count].value = 0;
+          operands[operand_count].unknown = 1;
+          break;
+        }
+
+        print_error_unexp(token, asm_context);
+        return -1;
       }
-      else
+
+      half = get_half(asm_context, &n);
+
+      if (half == -1) { return -1; }
+
+      operands[operand_count].value = n;
+
+      token_type = tokens_get(asm_context, token, TOKENLEN);
+      if (IS_TOKEN(token, '('))
       {
-        tokens_push(asm_context, token, token_type);
-        if (eval_expression(asm_context, &n) != 0)
+        // The low half is a signed offset.
+        if (half == HALF_LO) { operands[operand_count].value = (int16_t)n; }
+
+        if (operands[operand_count].value < -32768 ||
+            operands[operand_count].value > 32767)
         {
-          print_error_unexp(token, asm_context);
+          print_error_range("Offset", -32768, 32767, asm_context);
           return -1;
         }
 
-        operands[operand_count].value = n;
-
         token_type = tokens_get(asm_context, token, TOKENLEN);
-        if (IS_TOKEN(token, '('))
-        {
-          if (operands[operand_count].value < -32768 ||
-              operands[operand_count].value > 32767)
-          {
-            print_error_range("Offset", -32768, 32767, asm_context);
-            return -1;
-          }
-
-          token_type = tokens_get(asm_context, token, TOKENLEN);
 
-          n = get_register_powerpc(token);
-          if (n == -1)
-          {
-            print_error_unexp(token, asm_context);
-            return -1;
-          }
+        n = get_register_powerpc(token);
+        if (n == -1)
+        {
+          print_error_unexp(token, asm_context);
+          return -1;
+        }
 
-          operands[operand_count].offset = (uint16_t)operands[operand_count].value;
-          operands[operand_count].type = OPERAND_REGISTER_OFFSET;
-          operands[operand_count].value = n;
+        operands[operand_count].offset = (uint16_t)operands[operand_count].value;
+        operands[operand_count].type = OPERAND_REGISTER_OFFSET;
+        operands[operand_count].value = n;
 
-          token_type = tokens_get(asm_context, token, TOKENLEN);
-          if (IS_NOT_TOKEN(token, ')'))
-          {
-            print_error_unexp(token, asm_context);
-            return -1;
-          }
-        }
-          else
+        token_type = tokens_get(asm_context, token, TOKENLEN);
+        if (IS_NOT_TOKEN(token, ')'))
         {
-          tokens_push(asm_context, token, token_type);
+          print_error_unexp(token, asm_context);
+          return -1;
         }
       }
+        else
+      {
+        tokens_push(asm_context, token, token_type);
+      }
 
       break;
     } while(0);
@@ -269,6 +341,199 @@ static int get_operands(struct _asm_context *asm_context, struct _operand *opera
   return operand_count;
 }
 
+static int get_branch_form(struct _asm_context *asm_context, struct _operand *operand, int bo)
+{
+  int offset = operand->value - asm_context->address;
+  int wanted;
+
+  if (operand->unknown == 1)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  if (offset >= -(1 << 15) && offset <= (1 << 15) - 1)
+  {
+    wanted = BRANCH_SHORT;
+  }
+    else
+  if ((bo & 0x14) == 0x04)
+  {
+    // Only tests a condition so it can be turned around.
+    wanted = BRANCH_INVERT;
+  }
+    else
+  {
+    wanted = BRANCH_SKIP;
+  }
+
+  return relax_form(asm_context, wanted);
+}
+
+static int write_branch(struct _asm_context *asm_context, struct _operand *operand, int address, int link)
+{
+  int offset = operand->value - address;
+
+  if (operand->unknown == 1) { offset = 0; }
+
+  if ((offset & 0x3) != 0)
+  {
+    print_error_align(asm_context, 4);
+    return -1;
+  }
+
+  if (offset < -(1 << 25) || offset > (1 << 25) - 1)
+  {
+    print_error_range("Offset", -(1 << 25), (1 << 25) - 1, asm_context);
+    return -1;
+  }
+
+  add_bin32(asm_context, 0x48000000 | (offset & 0x03fffffc) | link, IS_OPCODE);
+
+  return 4;
+}
+
+static int write_branch_cond(struct _asm_context *asm_context, uint32_t opcode, struct _operand *operand, int form)
+{
+  int link = opcode & 1;
+  int offset;
+
+  if (form == BRANCH_INVERT)
+  {
+    // bc !cond, skip
+    // b label
+    // skip:
+    add_bin32(asm_context, ((opcode ^ (0x08 << 21)) & ~1) | 8, IS_OPCODE);
+
+    // address has already moved past the bc.
+    if (write_branch(asm_context, operand, asm_context->address, link) == -1)
+    {
+      return -1;
+    }
+
+    return 8;
+  }
+
+  if (form == BRANCH_SKIP)
+  {
+    // Anything that also counts down ctr can't be turned around so:
+    // bc cond, far
+    // b skip
+    // far: b label
+    // skip:
+    add_bin32(asm_context, (opcode & ~1) | 8, IS_OPCODE);
+    add_bin32(asm_context, 0x48000008, IS_OPCODE);
+
+    if (write_branch(asm_context, operand, asm_context->address, link) == -1)
+    {
+      return -1;
+    }
+
+    return 12;
+  }
+
+  offset = operand->value - asm_context->address;
+
+  if (operand->unknown == 1) { offset = 0; }
+
+  if ((offset & 0x3) != 0)
+  {
+    print_error_align(asm_context, 4);
+    return -1;
+  }
+
+  if (offset < -(1 << 15) || offset > (1 << 15) - 1)
+  {
+    print_error_range("Offset", -(1 << 15), (1 << 15) - 1, asm_context);
+    return -1;
+  }
+
+  add_bin32(asm_context, opcode | (offset & 0xfffc), IS_OPCODE);
+
+  return 4;
+}
+
+static int write_veneer(struct _asm_context *asm_context, struct _operand *operand, int link)
+{
+  uint32_t address = operand->value;
+
+  // A b or bl that can't reach goes through ctr, using r12 as scratch:
+  // lis r12, label@h
+  // ori r12, r12, label@l
+  // mtctr r12
+  // bctr (or bctrl)
+  add_bin32(asm_context, 0x3d800000 | (address >> 16), IS_OPCODE);
+  add_bin32(asm_context, 0x618c0000 | (address & 0xffff), IS_OPCODE);
+  add_bin32(asm_context, 0x7d8903a6, IS_OPCODE);
+  add_bin32(asm_context, 0x4e800420 | link, IS_OPCODE);
+
+  return 16;
+}
+
+static int parse_li32(struct _asm_context *asm_context, char *instr, struct _operand *operands, int operand_count)
+{
+  int value = operands[1].value;
+  int fits;
+  int form;
+
+  if (operand_count != 2)
+  {
+    print_error_opcount(instr, asm_context);
+    return -1;
+  }
+
+  if (operands[0].type != OPERAND_REGISTER ||
+      operands[1].type != OPERAND_NUMBER)
+  {
+    print_error_illegal_operands(instr, asm_context);
+    return -1;
+  }
+
+  // One instruction if li or lis alone can load it.
+  fits = (value >= -32768 && value <= 32767) || (value & 0xffff) == 0;
+
+  // A label further down in the file is only known once pass 1 is
+  // repeated so without .relax it always gets lis/ori.
+  if (operands[1].unknown == 1)
+  {
+    form = asm_context->relax.enabled == 1 ? RELAX_UNKNOWN : 1;
+  }
+    else
+  {
+    form = fits == 1 ? 0 : 1;
+  }
+
+  form = relax_form(asm_context, form);
+
+  if (form == 0 && fits == 1)
+  {
+    if (relax_forward(asm_context) == 1) { relax_shortened(asm_context); }
+
+    if (value >= -32768 && value <= 32767)
+    {
+      add_bin32(asm_context, 0x38000000 | (operands[0].value << 21) | (value & 0xffff), IS_OPCODE);
+    }
+      else
+    {
+      add_bin32(asm_context, 0x3c000000 | (operands[0].value << 21) | ((value >> 16) & 0xffff), IS_OPCODE);
+    }
+
+    return 4;
+  }
+
+  if (form == 0 && asm_context->pass == 2)
+  {
+    print_error_range("Immediate", -32768, 32767, asm_context);
+    return -1;
+  }
+
+  // lis rd, value@h
+  // ori rd, rd, value@l
+  add_bin32(asm_context, 0x3c000000 | (operands[0].value << 21) | ((value >> 16) & 0xffff), IS_OPCODE);
+  add_bin32(asm_context, 0x60000000 | (operands[0].value << 21) | (operands[0].value << 16) | (value & 0xffff), IS_OPCODE);
+
+  return 8;
+}
+
 int parse_instruction_powerpc(struct _asm_context *asm_context, char *instr)
 {
   char instr_case[TOKENLEN];
@@ -290,6 +555,11 @@ int parse_instruction_powerpc(struct _asm_context *asm_context, char *instr)
 
   if (operand_count < 0) { return -1; }
 
+  if (strcmp(instr_case, "li32") == 0)
+  {
+    return parse_li32(asm_context, instr, operands, operand_count);
+  }
+
   n = 0;
   while(table_powerpc[n].instr != NULL)
   {
@@ -601,27 +871,27 @@ int parse_instruction_powerpc(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          offset = (uint32_t)operands[0].value - asm_context->address;
-
-          if ((offset & 0x3) != 0)
+          // With .relax a b or bl that can't reach goes through ctr.
+          if (asm_context->relax.enabled == 1)
           {
-            print_error_align(asm_context, 4);
-            return -1;
-          }
+            offset = operands[0].value - asm_context->address;
 
-          temp = (offset >> 26) & 0x3f;
+            if (operands[0].unknown == 1)
+            {
+              temp = RELAX_UNKNOWN;
+            }
+              else
+            {
+              temp = (offset < -(1 << 25) || offset > (1 << 25) - 1) ? 1 : 0;
+            }
 
-          if (temp != 0 && temp != 0x3f)
-          {
-            print_error_range("Offset", -(1 << 25), (1 << 25) - 1, asm_context);
-            return -1;
+            if (relax_form(asm_context, temp) == 1)
+            {
+              return write_veneer(asm_context, &operands[0], table_powerpc[n].opcode & 1);
+            }
           }
 
-          opcode = table_powerpc[n].opcode | (offset & ((1 << 26) - 1));
-
-          add_bin32(asm_context, opcode, IS_OPCODE);
-
-          return 4;
+          return write_branch(asm_context, &operands[0], asm_context->address, table_powerpc[n].opcode & 1);
         }
         case OP_JUMP:
         {
@@ -673,22 +943,6 @@ int parse_instruction_powerpc(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          offset = (uint32_t)operands[2].value - asm_context->address;
-
-          if ((offset & 0x3) != 0)
-          {
-            print_error_align(asm_context, 4);
-            return -1;
-          }
-
-          temp = offset & 0xffff0000;
-
-          if (temp != 0 && temp != 0xffff0000)
-          {
-            print_error_range("Offset", -(1 << 15), (1 << 15) - 1, asm_context);
-            return -1;
-          }
-
           if (operands[0].value < 0 || operands[0].value > 31 ||
               operands[1].value < 0 || operands[1].value > 31)
           {
@@ -698,12 +952,11 @@ int parse_instruction_powerpc(struct _asm_context *asm_context, char *instr)
 
           opcode = table_powerpc[n].opcode |
                    (operands[0].value << 21) |
-                   (operands[1].value << 16) |
-                   (offset & 0xfffc);
+                   (operands[1].value << 16);
 
-          add_bin32(asm_context, opcode, IS_OPCODE);
+          temp = get_branch_form(asm_context, &operands[2], operands[0].value);
 
-          return 4;
+          return write_branch_cond(asm_context, opcode, &operands[2], temp);
         }
         case OP_JUMP_COND_BD:
         {
@@ -804,22 +1057,6 @@ int parse_instruction_powerpc(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          offset = (uint32_t)operands[1].value - asm_context->address;
-
-          if ((offset & 0x3) != 0)
-          {
-            print_error_align(asm_context, 4);
-            return -1;
-          }
-
-          temp = offset & 0xffff0000;
-
-          if (temp != 0 && temp != 0xffff0000)
-          {
-            print_error_range("Offset", -(1 << 15), (1 << 15) - 1, asm_context);
-            return -1;
-          }
-
           if (operands[0].value < 0 || operands[0].value > 31)
           {
             print_error_range("Constant", 0, 31, asm_context);
@@ -827,12 +1064,11 @@ int parse_instruction_powerpc(struct _asm_context *asm_context, char *instr)
           }
 
           opcode = table_powerpc[n].opcode |
-                   (operands[0].value << 16) |
-                   (offset & 0xfffc);
+                   (operands[0].value << 16);
 
-          add_bin32(asm_context, opcode, IS_OPCODE);
+          temp = get_branch_form(asm_context, &operands[1], (opcode >> 21) & 0x1f);
 
-          return 4;
+          return write_branch_cond(asm_context, opcode, &operands[1], temp);
         }
         case OP_CMP:
         {
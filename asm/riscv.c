@@ -33,6 +33,15 @@ enum
   OPERAND_REGISTER_OFFSET,
 };
 
+// Sizes for pseudo instructions.  These are relax forms so they only
+// grow from one pass to the next.
+enum
+{
+  PSEUDO_COMPRESSED,
+  PSEUDO_SINGLE,
+  PSEUDO_PAIR,
+};
+
 #define RM_RNE 0
 #define RM_RTZ 1
 #define RM_RDN 2
@@ -44,6 +53,7 @@ struct _operand
   int value;
   int type;
   int16_t offset;
+  uint8_t unknown;
 };
 
 struct _modifiers
@@ -287,20 +297,23 @@ static int get_operands(struct _asm_context *asm_context, struct _operand *opera
       // Assume this is just a number
       operands[operand_count].type = OPERAND_NUMBER;
 
-      if (asm_context->pass == 1)
-      {
-        eat_operand(asm_context);
-        operands[operand_count].value = 0;
-      }
-      else
+      tokens_push(asm_context, token, token_type);
+
+      if (eval_expression(asm_context, &n) != 0)
       {
-        tokens_push(asm_context, token, token_type);
-        if (eval_expression(asm_context, &n) != 0)
+        if (asm_context->pass == 2)
         {
           print_error_unexp(token, asm_context);
           return -1;
         }
 
+        // Labels further down in the file aren't known yet.
+        eat_operand(asm_context);
+        operands[operand_count].value = 0;
+        operands[operand_count].unknown = 1;
+      }
+      else
+      {
         operands[operand_count].value = n;
 
         token_type = tokens_get(asm_context, token, TOKENLEN);
@@ -364,6 +377,659 @@ static int get_operands(struct _asm_context *asm_context, struct _operand *opera
   return operand_count;
 }
 
+// Branches and jumps, compressed or not, are relative to the address of
+// the instruction itself.
+static int get_offset(struct _asm_context *asm_context, int address)
+{
+  return address - asm_context->address;
+}
+
+static int is_c_register(struct _operand *operand)
+{
+  return operand->type == OPERAND_X_REGISTER &&
+         operand->value >= 8 && operand->value <= 15;
+}
+
+static int is_x_register(struct _operand *operand, int value)
+{
+  return operand->type == OPERAND_X_REGISTER && operand->value == value;
+}
+
+// Returns the 16 bit opcode for a compressed instruction or -1 if the
+// operands can't be encoded.
+static int get_compressed(struct _asm_context *asm_context, int n, struct _operand *operands, int operand_count)
+{
+  int opcode = table_riscv_comp[n].opcode;
+  int rd = operands[0].value;
+  int rs = operands[1].value;
+  int imm, offset;
+
+  switch(table_riscv_comp[n].type)
+  {
+    case OP_C_NONE:
+      if (operand_count != 0) { return -1; }
+      return opcode;
+    case OP_C_ADDI4SPN:
+      if (operand_count != 3 || !is_c_register(&operands[0]) ||
+          !is_x_register(&operands[1], 2) ||
+          operands[2].type != OPERAND_NUMBER) { return -1; }
+      imm = operands[2].value;
+      if (imm <= 0 || imm > 1020 || (imm & 3) != 0) { return -1; }
+      return opcode |
+             (((imm >> 4) & 0x3) << 11) |
+             (((imm >> 6) & 0xf) << 7) |
+             (((imm >> 2) & 0x1) << 6) |
+             (((imm >> 3) & 0x1) << 5) |
+             ((rd - 8) << 2);
+    case OP_C_LOAD:
+    case OP_C_STORE:
+      if (operand_count != 2 || !is_c_register(&operands[0]) ||
+          operands[1].type != OPERAND_REGISTER_OFFSET ||
+          rs < 8 || rs > 15) { return -1; }
+      imm = operands[1].offset;
+      if (imm < 0 || imm > 124 || (imm & 3) != 0) { return -1; }
+      return opcode |
+             (((imm >> 3) & 0x7) << 10) |
+             ((rs - 8) << 7) |
+             (((imm >> 2) & 0x1) << 6) |
+             (((imm >> 6) & 0x1) << 5) |
+             ((rd - 8) << 2);
+    case OP_C_RD_IMM:
+    case OP_C_ANDI:
+      if (operand_count != 2 || operands[1].type != OPERAND_NUMBER) { return -1; }
+      if (table_riscv_comp[n].type == OP_C_ANDI)
+      {
+        if (!is_c_register(&operands[0])) { return -1; }
+        opcode |= (rd - 8) << 7;
+      }
+        else
+      {
+        if (operands[0].type != OPERAND_X_REGISTER || rd == 0) { return -1; }
+        opcode |= rd << 7;
+      }
+      imm = operands[1].value;
+      if (imm < -32 || imm > 31) { return -1; }
+      return opcode | (((imm >> 5) & 0x1) << 12) | ((imm & 0x1f) << 2);
+    case OP_C_JUMP:
+      if (operand_count != 1 || operands[0].type != OPERAND_NUMBER) { return -1; }
+      offset = get_offset(asm_context, operands[0].value);
+      if (offset < -2048 || offset > 2046 || (offset & 1) != 0) { return -1; }
+      return opcode |
+             (((offset >> 11) & 0x1) << 12) |
+             (((offset >> 4) & 0x1) << 11) |
+             (((offset >> 8) & 0x3) << 9) |
+             (((offset >> 10) & 0x1) << 8) |
+             (((offset >> 6) & 0x1) << 7) |
+             (((offset >> 7) & 0x1) << 6) |
+             (((offset >> 1) & 0x7) << 3) |
+             (((offset >> 5) & 0x1) << 2);
+    case OP_C_ADDI16SP:
+      if (operand_count != 2 || !is_x_register(&operands[0], 2) ||
+          operands[1].type != OPERAND_NUMBER) { return -1; }
+      imm = operands[1].value;
+      if (imm == 0 || imm < -512 || imm > 496 || (imm & 15) != 0) { return -1; }
+      return opcode |
+             (((imm >> 9) & 0x1) << 12) |
+             (((imm >> 4) & 0x1) << 6) |
+             (((imm >> 6) & 0x1) << 5) |
+             (((imm >> 7) & 0x3) << 3) |
+             (((imm >> 5) & 0x1) << 2);
+    case OP_C_LUI:
+      if (operand_count != 2 || operands[0].type != OPERAND_X_REGISTER ||
+          operands[1].type != OPERAND_NUMBER ||
+          rd == 0 || rd == 2) { return -1; }
+      // Same immediate as lui (the upper 20 bits) sign extended from 6 bits.
+      imm = operands[1].value;
+      if (imm >= 0xfffe0 && imm <= 0xfffff) { imm -= 0x100000; }
+      if (imm == 0 || imm < -32 || imm > 31) { return -1; }
+      return opcode | (rd << 7) | (((imm >> 5) & 0x1) << 12) | ((imm & 0x1f) << 2);
+    case OP_C_SHIFT:
+    case OP_C_SLLI:
+      if (operand_count != 2 || operands[1].type != OPERAND_NUMBER) { return -1; }
+      if (table_riscv_comp[n].type == OP_C_SHIFT)
+      {
+        if (!is_c_register(&operands[0])) { return -1; }
+        opcode |= (rd - 8) << 7;
+      }
+        else
+      {
+        if (operands[0].type != OPERAND_X_REGISTER || rd == 0) { return -1; }
+        opcode |= rd << 7;
+      }
+      imm = operands[1].value;
+      if (imm < 1 || imm > 31) { return -1; }
+      return opcode | (imm << 2);
+    case OP_C_ALU:
+      if (operand_count != 2 || !is_c_register(&operands[0]) ||
+          !is_c_register(&operands[1])) { return -1; }
+      return opcode | ((rd - 8) << 7) | ((rs - 8) << 2);
+    case OP_C_BRANCH:
+      if (operand_count != 2 || !is_c_register(&operands[0]) ||
+          operands[1].type != OPERAND_NUMBER) { return -1; }
+      offset = get_offset(asm_context, operands[1].value);
+      if (offset < -256 || offset > 254 || (offset & 1) != 0) { return -1; }
+      return opcode |
+             (((offset >> 8) & 0x1) << 12) |
+             (((offset >> 3) & 0x3) << 10) |
+             ((rd - 8) << 7) |
+             (((offset >> 6) & 0x3) << 5) |
+             (((offset >> 1) & 0x3) << 3) |
+             (((offset >> 5) & 0x1) << 2);
+    case OP_C_LWSP:
+    case OP_C_SWSP:
+      if (operand_count != 2 || operands[0].type != OPERAND_X_REGISTER ||
+          operands[1].type != OPERAND_REGISTER_OFFSET || rs != 2) { return -1; }
+      imm = operands[1].offset;
+      if (imm < 0 || imm > 252 || (imm & 3) != 0) { return -1; }
+      if (table_riscv_comp[n].type == OP_C_SWSP)
+      {
+        return opcode |
+               (((imm >> 2) & 0xf) << 9) |
+               (((imm >> 6) & 0x3) << 7) |
+               (rd << 2);
+      }
+      if (rd == 0) { return -1; }
+      return opcode |
+             (((imm >> 5) & 0x1) << 12) |
+             (rd << 7) |
+             (((imm >> 2) & 0x7) << 4) |
+             (((imm >> 6) & 0x3) << 2);
+    case OP_C_JR:
+      if (operand_count != 1 || operands[0].type != OPERAND_X_REGISTER ||
+          rd == 0) { return -1; }
+      return opcode | (rd << 7);
+    case OP_C_MV:
+      if (operand_count != 2 || operands[0].type != OPERAND_X_REGISTER ||
+          operands[1].type != OPERAND_X_REGISTER ||
+          rd == 0 || rs == 0) { return -1; }
+      return opcode | (rd << 7) | (rs << 2);
+    default:
+      break;
+  }
+
+  return -1;
+}
+
+static int find_compressed(const char *instr)
+{
+  int n = 0;
+
+  while(table_riscv_comp[n].instr != NULL)
+  {
+    if (strcmp(table_riscv_comp[n].instr, instr) == 0) { return n; }
+    n++;
+  }
+
+  return -1;
+}
+
+static int try_compressed(struct _asm_context *asm_context, const char *instr, int operand_count, struct _operand *operand0, struct _operand *operand1, struct _operand *operand2)
+{
+  struct _operand operands[3];
+
+  memset(operands, 0, sizeof(operands));
+
+  if (operand0 != NULL) { operands[0] = *operand0; }
+  if (operand1 != NULL) { operands[1] = *operand1; }
+  if (operand2 != NULL) { operands[2] = *operand2; }
+
+  return get_compressed(asm_context, find_compressed(instr), operands, operand_count);
+}
+
+// Returns the compressed version of a 32 bit instruction or -1 if there
+// isn't one for these operands.
+static int compress_instruction(struct _asm_context *asm_context, char *instr_case, struct _operand *operands, int operand_count)
+{
+  struct _operand *rd = &operands[0];
+  struct _operand *rs1 = &operands[1];
+  struct _operand *rs2 = &operands[2];
+  struct _operand address;
+  int opcode = -1;
+
+  if (strcmp(instr_case, "add") == 0 && operand_count == 3)
+  {
+    if (rd->value == rs1->value)
+    { opcode = try_compressed(asm_context, "c.add", 2, rd, rs2, NULL); }
+    if (opcode == -1 && rd->value == rs2->value)
+    { opcode = try_compressed(asm_context, "c.add", 2, rd, rs1, NULL); }
+    if (opcode == -1 && is_x_register(rs1, 0))
+    { opcode = try_compressed(asm_context, "c.mv", 2, rd, rs2, NULL); }
+    if (opcode == -1 && is_x_register(rs2, 0))
+    { opcode = try_compressed(asm_context, "c.mv", 2, rd, rs1, NULL); }
+  }
+    else
+  if ((strcmp(instr_case, "sub") == 0 ||
+       strcmp(instr_case, "xor") == 0 ||
+       strcmp(instr_case, "or") == 0 ||
+       strcmp(instr_case, "and") == 0) && operand_count == 3)
+  {
+    char instr[8];
+
+    sprintf(instr, "c.%s", instr_case);
+
+    if (rd->value == rs1->value)
+    { opcode = try_compressed(asm_context, instr, 2, rd, rs2, NULL); }
+    if (opcode == -1 && rd->value == rs2->value && instr_case[0] != 's')
+    { opcode = try_compressed(asm_context, instr, 2, rd, rs1, NULL); }
+  }
+    else
+  if (strcmp(instr_case, "addi") == 0 && operand_count == 3)
+  {
+    if (is_x_register(rd, 0) && is_x_register(rs1, 0) && rs2->value == 0)
+    { opcode = try_compressed(asm_context, "c.nop", 0, NULL, NULL, NULL); }
+    if (opcode == -1 && rs2->value == 0)
+    { opcode = try_compressed(asm_context, "c.mv", 2, rd, rs1, NULL); }
+    if (opcode == -1 && rd->value == rs1->value)
+    { opcode = try_compressed(asm_context, "c.addi", 2, rd, rs2, NULL); }
+    if (opcode == -1 && rd->value == rs1->value)
+    { opcode = try_compressed(asm_context, "c.addi16sp", 2, rd, rs2, NULL); }
+    if (opcode == -1 && is_x_register(rs1, 0))
+    { opcode = try_compressed(asm_context, "c.li", 2, rd, rs2, NULL); }
+    if (opcode == -1)
+    { opcode = try_compressed(asm_context, "c.addi4spn", 3, rd, rs1, rs2); }
+  }
+    else
+  if ((strcmp(instr_case, "andi") == 0 ||
+       strcmp(instr_case, "slli") == 0 ||
+       strcmp(instr_case, "srli") == 0 ||
+       strcmp(instr_case, "srai") == 0) && operand_count == 3)
+  {
+    char instr[8];
+
+    sprintf(instr, "c.%s", instr_case);
+
+    if (rd->value == rs1->value)
+    { opcode = try_compressed(asm_context, instr, 2, rd, rs2, NULL); }
+  }
+    else
+  if (strcmp(instr_case, "lui") == 0 && operand_count == 2)
+  {
+    opcode = try_compressed(asm_context, "c.lui", 2, rd, rs1, NULL);
+  }
+    else
+  if ((strcmp(instr_case, "lw") == 0 || strcmp(instr_case, "sw") == 0) &&
+      (operand_count == 2 || operand_count == 3))
+  {
+    char *instr = instr_case[0] == 'l' ? "c.lw" : "c.sw";
+    char *instr_sp = instr_case[0] == 'l' ? "c.lwsp" : "c.swsp";
+
+    // lw rd, rs1, offset is the same as lw rd, offset(rs1).
+    if (operand_count == 3)
+    {
+      address.type = OPERAND_REGISTER_OFFSET;
+      address.value = rs1->value;
+      address.offset = rs2->value;
+      rs1 = &address;
+    }
+
+    opcode = try_compressed(asm_context, instr, 2, rd, rs1, NULL);
+    if (opcode == -1)
+    { opcode = try_compressed(asm_context, instr_sp, 2, rd, rs1, NULL); }
+  }
+    else
+  if (strcmp(instr_case, "jalr") == 0 && operand_count == 3)
+  {
+    if (rs2->value == 0 && is_x_register(rd, 0))
+    { opcode = try_compressed(asm_context, "c.jr", 1, rs1, NULL, NULL); }
+    if (rs2->value == 0 && is_x_register(rd, 1))
+    { opcode = try_compressed(asm_context, "c.jalr", 1, rs1, NULL, NULL); }
+  }
+    else
+  if (strcmp(instr_case, "jal") == 0 && operand_count == 2)
+  {
+    if (is_x_register(rd, 0))
+    { opcode = try_compressed(asm_context, "c.j", 1, rs1, NULL, NULL); }
+    if (is_x_register(rd, 1))
+    { opcode = try_compressed(asm_context, "c.jal", 1, rs1, NULL, NULL); }
+  }
+    else
+  if ((strcmp(instr_case, "beq") == 0 || strcmp(instr_case, "bne") == 0) &&
+      operand_count == 3)
+  {
+    char *instr = instr_case[1] == 'e' ? "c.beqz" : "c.bnez";
+
+    if (is_x_register(rs1, 0))
+    { opcode = try_compressed(asm_context, instr, 2, rd, rs2, NULL); }
+    if (opcode == -1 && is_x_register(rd, 0))
+    { opcode = try_compressed(asm_context, instr, 2, rs1, rs2, NULL); }
+  }
+    else
+  if (strcmp(instr_case, "sbreak") == 0 && operand_count == 0)
+  {
+    opcode = try_compressed(asm_context, "c.ebreak", 0, NULL, NULL, NULL);
+  }
+
+  return opcode;
+}
+
+static int parse_compressed(struct _asm_context *asm_context, char *instr, char *instr_case, struct _operand *operands, int operand_count)
+{
+  int opcode;
+  int n;
+
+  n = find_compressed(instr_case);
+
+  if (n == -1) { return 0; }
+
+  // Always 2 bytes so there is nothing to check until labels are known.
+  if (asm_context->pass == 1)
+  {
+    add_bin16(asm_context, table_riscv_comp[n].opcode, IS_OPCODE);
+    return 2;
+  }
+
+  opcode = get_compressed(asm_context, n, operands, operand_count);
+
+  if (opcode == -1)
+  {
+    print_error_illegal_operands(instr, asm_context);
+    return -1;
+  }
+
+  add_bin16(asm_context, opcode, IS_OPCODE);
+
+  return 2;
+}
+
+static int is_compressible(char *instr_case)
+{
+  const char *compressible[] =
+  {
+    "add", "sub", "xor", "or", "and", "addi", "andi", "slli", "srli",
+    "srai", "lui", "lw", "sw", "jalr", "jal", "beq", "bne", "sbreak", NULL
+  };
+  int n = 0;
+
+  while(compressible[n] != NULL)
+  {
+    if (strcmp(compressible[n], instr_case) == 0) { return 1; }
+    n++;
+  }
+
+  return 0;
+}
+
+static int parse_auto_compress(struct _asm_context *asm_context, char *instr_case, struct _operand *operands, int operand_count)
+{
+  int opcode;
+  int form;
+  int n;
+
+  if (asm_context->relax.enabled == 0 || !is_compressible(instr_case))
+  {
+    return 0;
+  }
+
+  // Form 0 is the compressed instruction, form 1 is 32 bits.  Every
+  // compressible instruction is a site (even if these registers can't
+  // be compressed) so sites are numbered the same way every pass.
+  opcode = compress_instruction(asm_context, instr_case, operands, operand_count);
+  form = opcode == -1 ? 1 : 0;
+
+  for (n = 0; n < operand_count; n++)
+  {
+    if (operands[n].unknown != 0) { form = RELAX_UNKNOWN; }
+  }
+
+  if (relax_form(asm_context, form) != 0) { return 0; }
+
+  if (asm_context->pass == 2)
+  {
+    if (opcode == -1)
+    {
+      print_error("Instruction can't be compressed (internal error)", asm_context);
+      return -1;
+    }
+
+    relax_shortened(asm_context);
+  }
+
+  add_bin16(asm_context, opcode == -1 ? 0 : opcode, IS_OPCODE);
+
+  return 2;
+}
+
+static int get_pseudo_operands(struct _asm_context *asm_context, char *instr, int *rd, int *value, int *known)
+{
+  char token[TOKENLEN];
+  int token_type;
+
+  // li/la take "rd, value", call/tail only take the address.
+  if (rd != NULL)
+  {
+    token_type = tokens_get(asm_context, token, TOKENLEN);
+    *rd = get_x_register_riscv(token);
+
+    if (*rd == -1)
+    {
+      print_error_illegal_operands(instr, asm_context);
+      return -1;
+    }
+
+    if (expect_token(asm_context, ',') == -1) { return -1; }
+  }
+
+  *known = 1;
+
+  if (eval_expression(asm_context, value) != 0)
+  {
+    if (asm_context->pass == 2)
+    {
+      print_error_illegal_expression(instr, asm_context);
+      return -1;
+    }
+
+    eat_operand(asm_context);
+    *value = 0;
+    *known = 0;
+  }
+
+  token_type = tokens_get(asm_context, token, TOKENLEN);
+
+  if (token_type != TOKEN_EOL && token_type != TOKEN_EOF)
+  {
+    print_error_unexp(token, asm_context);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int add_li(struct _asm_context *asm_context, int rd, int value, int known)
+{
+  struct _operand operands[2];
+  uint32_t hi = (((uint32_t)value + 0x800) >> 12) & 0xfffff;
+  int lo = value & 0xfff;
+  int compressed = -1;
+  int form;
+
+  // With .relax a value that fits c.li or c.lui only takes 2 bytes.
+  if (asm_context->relax.enabled == 1)
+  {
+    memset(operands, 0, sizeof(operands));
+    operands[0].type = OPERAND_X_REGISTER;
+    operands[0].value = rd;
+    operands[1].type = OPERAND_NUMBER;
+    operands[1].value = value;
+
+    compressed = try_compressed(asm_context, "c.li", 2, &operands[0], &operands[1], NULL);
+
+    if (compressed == -1 && lo == 0)
+    {
+      operands[1].value = hi;
+      compressed = try_compressed(asm_context, "c.lui", 2, &operands[0], &operands[1], NULL);
+    }
+  }
+
+  // A single addi or lui if possible, otherwise lui and addi.  The lui
+  // is rounded up when the addi's immediate is going to be negative.
+  if (known == 0) { form = RELAX_UNKNOWN; }
+  else if (compressed != -1) { form = PSEUDO_COMPRESSED; }
+  else if ((value >= -2048 && value < 2048) || lo == 0) { form = PSEUDO_SINGLE; }
+  else { form = PSEUDO_PAIR; }
+
+  form = relax_form(asm_context, form);
+
+  if (form == PSEUDO_COMPRESSED && asm_context->relax.enabled == 0)
+  {
+    form = PSEUDO_SINGLE;
+  }
+
+  if (form == PSEUDO_COMPRESSED)
+  {
+    if (asm_context->pass == 2 && compressed == -1)
+    {
+      print_error("Instruction can't be compressed (internal error)", asm_context);
+      return -1;
+    }
+
+    relax_shortened(asm_context);
+
+    add_bin16(asm_context, compressed == -1 ? 0 : compressed, IS_OPCODE);
+
+    return 2;
+  }
+
+  if (form == PSEUDO_SINGLE)
+  {
+    if (value >= -2048 && value < 2048)
+    {
+      add_bin32(asm_context, 0x00000013 | (lo << 20) | (rd << 7), IS_OPCODE);
+    }
+      else
+    {
+      add_bin32(asm_context, 0x00000037 | (hi << 12) | (rd << 7), IS_OPCODE);
+    }
+
+    return 4;
+  }
+
+  add_bin32(asm_context, 0x00000037 | (hi << 12) | (rd << 7), IS_OPCODE);
+  add_bin32(asm_context, 0x00000013 | (lo << 20) | (rd << 15) | (rd << 7), IS_OPCODE);
+
+  return 8;
+}
+
+static int add_call(struct _asm_context *asm_context, int rd, int rs, int address, int known)
+{
+  struct _operand operand;
+  int32_t offset = get_offset(asm_context, address);
+  uint32_t immediate;
+  uint32_t hi;
+  int compressed = -1;
+  int form;
+
+  if (asm_context->pass == 2 && (address & 1) != 0)
+  {
+    print_error("Address isn't on a 16 bit boundary", asm_context);
+    return -1;
+  }
+
+  // With .relax a close enough target only needs c.jal or c.j.
+  if (asm_context->relax.enabled == 1)
+  {
+    memset(&operand, 0, sizeof(operand));
+    operand.type = OPERAND_NUMBER;
+    operand.value = address;
+
+    compressed = try_compressed(asm_context, rd == 1 ? "c.jal" : "c.j", 1, &operand, NULL, NULL);
+  }
+
+  // A jal if within +-1MB, otherwise auipc and jalr.
+  if (known == 0) { form = RELAX_UNKNOWN; }
+  else if (compressed != -1) { form = PSEUDO_COMPRESSED; }
+  else if (offset >= -(1 << 20) && offset < (1 << 20)) { form = PSEUDO_SINGLE; }
+  else { form = PSEUDO_PAIR; }
+
+  form = relax_form(asm_context, form);
+
+  if (form == PSEUDO_COMPRESSED && asm_context->relax.enabled == 0)
+  {
+    form = PSEUDO_SINGLE;
+  }
+
+  if (form == PSEUDO_COMPRESSED)
+  {
+    if (asm_context->pass == 2 && compressed == -1)
+    {
+      print_error_range("Offset", -2048, 2046, asm_context);
+      return -1;
+    }
+
+    relax_shortened(asm_context);
+
+    add_bin16(asm_context, compressed == -1 ? 0 : compressed, IS_OPCODE);
+
+    return 2;
+  }
+
+  if (form == PSEUDO_SINGLE)
+  {
+    if (asm_context->pass == 2 && (offset < -(1 << 20) || offset >= (1 << 20)))
+    {
+      print_error_range("Offset", -(1 << 20), (1 << 20) - 2, asm_context);
+      return -1;
+    }
+
+    immediate = ((offset >> 20) & 0x1) << 31;
+    immediate |= ((offset >> 12) & 0xff) << 12;
+    immediate |= ((offset >> 11) & 0x1) << 20;
+    immediate |= ((offset >> 1) & 0x3ff) << 21;
+
+    relax_shortened(asm_context);
+
+    add_bin32(asm_context, 0x0000006f | immediate | (rd << 7), IS_OPCODE);
+
+    return 4;
+  }
+
+  hi = (((uint32_t)offset + 0x800) >> 12) & 0xfffff;
+
+  add_bin32(asm_context, 0x00000017 | (hi << 12) | (rs << 7), IS_OPCODE);
+  add_bin32(asm_context, 0x00000067 | ((offset & 0xfff) << 20) | (rs << 15) | (rd << 7), IS_OPCODE);
+
+  return 8;
+}
+
+static int parse_pseudo(struct _asm_context *asm_context, char *instr, char *instr_case)
+{
+  int rd, value, known;
+
+  if (strcmp(instr_case, "li") == 0 || strcmp(instr_case, "la") == 0)
+  {
+    if (get_pseudo_operands(asm_context, instr, &rd, &value, &known) != 0)
+    {
+      return -1;
+    }
+
+    return add_li(asm_context, rd, value, known);
+  }
+
+  if (strcmp(instr_case, "call") == 0)
+  {
+    if (get_pseudo_operands(asm_context, instr, NULL, &value, &known) != 0)
+    {
+      return -1;
+    }
+
+    // The return address register is also used for the upper bits.
+    return add_call(asm_context, 1, 1, value, known);
+  }
+
+  if (strcmp(instr_case, "tail") == 0)
+  {
+    if (get_pseudo_operands(asm_context, instr, NULL, &value, &known) != 0)
+    {
+      return -1;
+    }
+
+    // No return address so the upper bits need a scratch register (t1).
+    return add_call(asm_context, 0, get_x_register_riscv("t1"), value, known);
+  }
+
+  return 0;
+}
+
 int parse_instruction_riscv(struct _asm_context *asm_context, char *instr)
 {
   char instr_case[TOKENLEN];
@@ -379,12 +1045,21 @@ int parse_instruction_riscv(struct _asm_context *asm_context, char *instr)
 
   lower_copy(instr_case, instr);
 
+  n = parse_pseudo(asm_context, instr, instr_case);
+  if (n != 0) { return n; }
+
   memset(&operands, 0, sizeof(operands));
 
   operand_count = get_operands(asm_context, operands, instr, instr_case, &modifiers);
 
   if (operand_count < 0) { return -1; }
 
+  n = parse_compressed(asm_context, instr, instr_case, operands, operand_count);
+  if (n != 0) { return n; }
+
+  n = parse_auto_compress(asm_context, instr_case, operands, operand_count);
+  if (n != 0) { return n; }
+
   n = 0;
   while(table_riscv[n].instr != NULL)
   {
@@ -559,7 +1234,7 @@ int parse_instruction_riscv(struct _asm_context *asm_context, char *instr)
 
           if (asm_context->pass == 2)
           {
-            offset = (uint32_t)operands[2].value - (asm_context->address + 4);
+            offset = get_offset(asm_context, operands[2].value);
 
             if ((offset & 0x1) != 0)
             {
@@ -567,9 +1242,9 @@ int parse_instruction_riscv(struct _asm_context *asm_context, char *instr)
               return -1;
             }
 
-            if (offset < -4096 || offset >= 4095)
+            if (offset < -4096 || offset > 4094)
             {
-              print_error_range("Offset", -4096, 4095, asm_context);
+              print_error_range("Offset", -4096, 4094, asm_context);
               return -1;
             }
           }
@@ -630,31 +1305,30 @@ int parse_instruction_riscv(struct _asm_context *asm_context, char *instr)
             return -1;
           }
 
-          int32_t address = 0;
+          int32_t offset = 0;
           uint32_t immediate;
 
           if (asm_context->pass == 2)
           {
-            //offset = (uint32_t)operands[1].value - (asm_context->address + 4);
-            address = operands[1].value;
+            offset = get_offset(asm_context, operands[1].value);
 
-            if ((address & 0x1) != 0)
+            if ((offset & 0x1) != 0)
             {
               print_error_illegal_operands(instr, asm_context);
               return -1;
             }
 
-            if (address < 0 || address >= (1 << 21))
+            if (offset < -(1 << 20) || offset >= (1 << 20))
             {
-              print_error_range("Offset", 0, (1 << 21) - 1, asm_context);
+              print_error_range("Offset", -(1 << 20), (1 << 20) - 2, asm_context);
               return -1;
             }
           }
 
-          immediate = ((address >> 20) & 0x1) << 31;
-          immediate |= ((address >> 12) & 0xff) << 12;
-          immediate |= ((address >> 11) & 0x1) << 20;
-          immediate |= ((address >> 1) & 0x3ff) << 21;
+          immediate = ((offset >> 20) & 0x1) << 31;
+          immediate |= ((offset >> 12) & 0xff) << 12;
+          immediate |= ((offset >> 11) & 0x1) << 20;
+          immediate |= ((offset >> 1) & 0x3ff) << 21;
 
           opcode = table_riscv[n].opcode | immediate | (operands[0].value << 7);
           add_bin32(asm_context, opcode, IS_OPCODE);
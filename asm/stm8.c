@@ -19,6 +19,7 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "disasm/stm8.h"
 #include "table/stm8.h"
 
@@ -30,11 +31,20 @@ enum
   NUM_SIZE_UNKNOWN,
 };
 
+enum
+{
+  BRANCH_SHORT,
+  BRANCH_LONG,
+  BRANCH_FAR,
+};
+
 struct _operand
 {
   uint8_t type;
   uint8_t reg;
   uint8_t num_size;
+  uint8_t unknown : 1;
+  uint8_t shortened : 1;
   int value;
 };
 
@@ -118,39 +128,71 @@ static int ignore_expression(struct _asm_context *asm_context)
   return -1;
 }
 
-static int get_num(struct _asm_context *asm_context, int instr_index, int *num, int *num_size)
+static int get_size(int num)
+{
+  if (num >= -128 && num <= 0xff) { return NUM_SIZE_SHORT; }
+  if (num >= -32768 && num <= 0xffff) { return NUM_SIZE_WORD; }
+  if (num >= -8388608 && num <=0xffffff) { return NUM_SIZE_EXTENDED; }
+
+  return -1;
+}
+
+static int get_num(struct _asm_context *asm_context, int instr_index, struct _operand *operand, int is_address)
 {
-  if (eval_expression(asm_context, num) != 0)
+  int wanted;
+
+  if (eval_expression(asm_context, &operand->value) != 0)
   {
-    if (asm_context->pass == 1)
+    if (asm_context->pass == 2)
     {
-      ignore_expression(asm_context);
-      //*num_size = get_minimum_size(instr_index);
-      *num_size = NUM_SIZE_UNKNOWN;
-      memory_write(asm_context, asm_context->address, *num_size, asm_context->line);
-      return 0;
+      print_error_illegal_expression(table_stm8[instr_index].instr, asm_context);
+      return -1;
     }
 
-    print_error_illegal_expression(table_stm8[instr_index].instr, asm_context);
-    return -1;
+    ignore_expression(asm_context);
+    operand->value = 0;
+    operand->unknown = 1;
+
+    // Without .relax a label further down in the file is assembled with
+    // the next bigger form (see find_bigger_instruction()).
+    if (is_address == 1 && asm_context->relax.enabled == 1)
+    {
+      wanted = RELAX_UNKNOWN;
+    }
+      else
+    {
+      wanted = NUM_SIZE_UNKNOWN;
+    }
   }
+    else
+  {
+    wanted = get_size(operand->value);
 
-  int override_size = memory_read(asm_context, asm_context->address);
+    if (wanted == -1)
+    {
+      // FIXME - bad error message
+      print_error_range("number", 0, 0xffffff, asm_context);
+      return -1;
+    }
+  }
 
-  if (asm_context->pass == 2 && override_size != 0)
+  // The size of an immediate comes from the instruction.
+  if (is_address == 0)
   {
-    *num_size = override_size;
+    operand->num_size = wanted;
     return 0;
   }
 
-  if (*num >= -128 && *num <= 0xff) { *num_size = NUM_SIZE_SHORT; return 0; }
-  if (*num >= -32768 && *num <= 0xffff) { *num_size = NUM_SIZE_WORD; return 0; }
-  if (*num >= -8388608 && *num <=0xffffff) { *num_size = NUM_SIZE_EXTENDED; return 0; }
+  // Each address is a relax site so pass 2 uses the same size as the
+  // last time through pass 1.
+  operand->num_size = relax_form(asm_context, wanted);
 
-  // FIXME - bad error message
-  print_error_range("number", 0, 0xffffff, asm_context);
+  if (operand->num_size == NUM_SIZE_SHORT && relax_forward(asm_context) == 1)
+  {
+    operand->shortened = 1;
+  }
 
-  return -1;
+  return 0;
 }
 
 static int add_bin_void(struct _asm_context *asm_context, int n)
@@ -292,6 +334,119 @@ static int add_bin_num16_num16(struct _asm_context *asm_context, int n, int num1
   return count;
 }
 
+static int is_shortened(int type, struct _operand *operands, int operand_count)
+{
+  int n;
+
+  if (type == OP_ADDRESS8_ADDRESS8)
+  {
+    return operands[0].type == OP_ADDRESS8 &&
+           operands[1].type == OP_ADDRESS8 &&
+           (operands[0].shortened == 1 || operands[1].shortened == 1);
+  }
+
+  for (n = 0; n < operand_count; n++)
+  {
+    if (operands[n].type == type && operands[n].shortened == 1) { return 1; }
+  }
+
+  return 0;
+}
+
+static int write_relative(struct _asm_context *asm_context, int n, struct _operand *operand)
+{
+  int prefix = table_stm8_opcodes[n].prefix;
+  int opcode = table_stm8_opcodes[n].opcode;
+  int address = asm_context->address + 2;
+  int offset, wanted, form, count;
+
+  if (prefix != 0) { address++; }
+
+  offset = operand->value - address;
+
+  if (operand->unknown == 1)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  if ((offset >= -128 && offset <= 127) || (prefix == 0 && opcode == 0x21))
+  {
+    // jrf never branches so it's left alone.
+    wanted = BRANCH_SHORT;
+  }
+    else
+  if ((operand->value >> 16) == (asm_context->address >> 16))
+  {
+    wanted = BRANCH_LONG;
+  }
+    else
+  {
+    wanted = BRANCH_FAR;
+  }
+
+  form = relax_form(asm_context, wanted);
+
+  if (form == BRANCH_SHORT)
+  {
+    if (asm_context->pass == 1)
+    {
+      offset = 0;
+    }
+      else
+    {
+      if (offset < -128 || offset > 127)
+      {
+        print_error_range("Offset", -128, 127, asm_context);
+        return -1;
+      }
+    }
+
+    return add_bin_num8(asm_context, n, offset);
+  }
+
+  // A branch that doesn't reach becomes jp/call (same 64k section) or
+  // jpf/callf.  Conditional ones jump over it with the opposite
+  // condition.
+  if (prefix == 0 && (opcode == 0x20 || opcode == 0xad))
+  {
+    if (opcode == 0x20)
+    {
+      add_bin8(asm_context, form == BRANCH_LONG ? 0xcc : 0xac, IS_OPCODE);
+    }
+      else
+    {
+      add_bin8(asm_context, form == BRANCH_LONG ? 0xcd : 0x8d, IS_OPCODE);
+    }
+
+    count = 1;
+  }
+    else
+  {
+    count = 3;
+
+    if (prefix != 0)
+    {
+      add_bin8(asm_context, prefix, IS_OPCODE);
+      count++;
+    }
+
+    add_bin8(asm_context, opcode ^ 1, IS_OPCODE);
+    add_bin8(asm_context, form == BRANCH_LONG ? 3 : 4, IS_OPCODE);
+    add_bin8(asm_context, form == BRANCH_LONG ? 0xcc : 0xac, IS_OPCODE);
+  }
+
+  if (form == BRANCH_FAR)
+  {
+    add_bin8(asm_context, (operand->value >> 16) & 0xff, IS_OPCODE);
+    count++;
+  }
+
+  add_bin8(asm_context, (operand->value >> 8) & 0xff, IS_OPCODE);
+  add_bin8(asm_context, operand->value & 0xff, IS_OPCODE);
+
+  return count + 2;
+}
+
 int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
 {
   char instr_case[TOKENLEN];
@@ -302,7 +457,6 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
   int instr_enum;
   int instr_index;
   int token_type;
-  int num_size;
   int n;
 
   lower_copy(instr_case, instr);
@@ -412,12 +566,12 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
       else
     if (IS_TOKEN(token,'#'))
     {
-      if (get_num(asm_context, instr_index, &n, &num_size) != 0)
+      if (get_num(asm_context, instr_index, &operands[operand_count], 0) != 0)
       {
         return -1;
       }
 
-      switch(num_size)
+      switch(operands[operand_count].num_size)
       {
         case NUM_SIZE_SHORT:
           operands[operand_count].type = OP_NUMBER8; break;
@@ -430,9 +584,6 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
           operands[operand_count].type = OP_NUMBER8; break;
           break;
       }
-
-      operands[operand_count].value = n;
-      operands[operand_count].num_size = num_size;
     }
       else
     if (IS_TOKEN(token,'('))
@@ -441,14 +592,11 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
 
       if (IS_TOKEN(token,'['))
       {
-        if (get_num(asm_context, instr_index, &n, &num_size) != 0)
+        if (get_num(asm_context, instr_index, &operands[operand_count], 1) != 0)
         {
           return -1;
         }
 
-        operands[operand_count].value = n;
-        operands[operand_count].num_size = num_size;
-
         int is_w = 1;
 
         token_type = tokens_get(asm_context, token, TOKENLEN);
@@ -489,7 +637,7 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
           print_error_unexp(token, asm_context);
         }
 
-        switch(num_size)
+        switch(operands[operand_count].num_size)
         {
           case NUM_SIZE_SHORT:
             if (is_w == 0)
@@ -523,14 +671,11 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
       {
         tokens_push(asm_context, token, token_type);
 
-        if (get_num(asm_context, instr_index, &n, &num_size) != 0)
+        if (get_num(asm_context, instr_index, &operands[operand_count], 1) != 0)
         {
           return -1;
         }
 
-        operands[operand_count].value = n;
-        operands[operand_count].num_size = num_size;
-
         if (expect_token(asm_context, ',') == -1) { return -1; }
 
         token_type = tokens_get(asm_context, token, TOKENLEN);
@@ -554,7 +699,7 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
           return -1;
         }
 
-        switch(num_size)
+        switch(operands[operand_count].num_size)
         {
           case NUM_SIZE_SHORT: break;
           case NUM_SIZE_WORD: operands[operand_count].type++; break;
@@ -572,12 +717,12 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
       else
     if (IS_TOKEN(token,'['))
     {
-      if (get_num(asm_context, instr_index, &n, &num_size) != 0)
+      if (get_num(asm_context, instr_index, &operands[operand_count], 1) != 0)
       {
         return -1;
       }
 
-      switch(num_size)
+      switch(operands[operand_count].num_size)
       {
         case NUM_SIZE_SHORT:
           operands[operand_count].type = OP_INDIRECT8; break;
@@ -591,9 +736,6 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
           break;
       }
 
-      operands[operand_count].value = n;
-      operands[operand_count].num_size = num_size;
-
       token_type = tokens_get(asm_context, token, TOKENLEN);
       if (IS_TOKEN(token,'.'))
       {
@@ -619,12 +761,12 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
     {
       tokens_push(asm_context, token, token_type);
 
-      if (get_num(asm_context, instr_index, &n, &num_size) != 0)
+      if (get_num(asm_context, instr_index, &operands[operand_count], 1) != 0)
       {
         return -1;
       }
 
-      switch(num_size)
+      switch(operands[operand_count].num_size)
       {
         case NUM_SIZE_SHORT:
           operands[operand_count].type = OP_ADDRESS8; break;
@@ -638,9 +780,6 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
           //return -1;
           operands[operand_count].type = OP_ADDRESS8; break;
       }
-
-      operands[operand_count].value = n;
-      operands[operand_count].num_size = num_size;
     }
 
     operand_count++;
@@ -686,6 +825,13 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
         }
       }
 
+      // Only count forms that have a bigger version.
+      if (find_bigger_instruction(n) != n &&
+          is_shortened(table_stm8_opcodes[n].type, operands, operand_count))
+      {
+        relax_shortened(asm_context);
+      }
+
       switch(table_stm8_opcodes[n].type)
       {
         case OP_NONE:
@@ -1071,24 +1217,7 @@ int parse_instruction_stm8(struct _asm_context *asm_context, char *instr)
                operands[0].type == OP_ADDRESS16 ||
                operands[0].type == OP_ADDRESS24))
           {
-            int address = asm_context->address + 2;
-            if (table_stm8_opcodes[n].prefix != 0) { address++; }
-            int offset = operands[0].value - address;
-
-            if (asm_context->pass == 1)
-            {
-              offset = 0;
-            }
-              else
-            {
-              if (offset < -128 || offset > 127)
-              {
-                print_error_range("Offset", -128, 127, asm_context);
-                return -1;
-              }
-            }
-
-            return add_bin_num8(asm_context, n, offset);
+            return write_relative(asm_context, n, &operands[0]);
           }
           break;
         }
@@ -19,8 +19,16 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/relax.h"
 #include "table/thumb.h"
 
+// Forms a branch can be relaxed to.
+enum
+{
+  BRANCH_SHORT,         // b<cond> or b
+  BRANCH_OVER_B,        // b<!cond> over a b
+};
+
 enum
 {
   OPERAND_NONE,
@@ -114,6 +122,71 @@ static int is_2_byte_aligned(struct _asm_context *asm_context, int num)
   return 0;
 }
 
+static int fits_branch(int offset, int bits)
+{
+  return offset >= -(1 << bits) && offset < (1 << bits);
+}
+
+static int parse_branch(struct _asm_context *asm_context, int address, int known, uint16_t opcode, int is_conditional)
+{
+  int offset = address - (asm_context->address + 4);
+  int wanted;
+  int form;
+
+  // Pick the smallest form that reaches.  A conditional branch that can't
+  // reach jumps over an unconditional one with the condition inverted.
+  // Anything further than that is out of range (there is no long branch
+  // that leaves lr alone).
+  if (known == 0)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  if (is_conditional == 0 || fits_branch(offset, 8))
+  {
+    wanted = BRANCH_SHORT;
+  }
+    else
+  {
+    wanted = BRANCH_OVER_B;
+  }
+
+  form = relax_form(asm_context, wanted);
+
+  if (asm_context->pass == 1)
+  {
+    offset = 0;
+    address = asm_context->address + 4;
+  }
+
+  if (is_2_byte_aligned(asm_context, offset) == -1) { return -1; }
+
+  if (form == BRANCH_SHORT)
+  {
+    if (is_conditional == 1)
+    {
+      if (check_range(asm_context, "Offset", offset, -256, 255) == -1) { return -1; }
+      add_bin16(asm_context, opcode | ((offset >> 1) & 0xff), IS_OPCODE);
+    }
+      else
+    {
+      if (check_range(asm_context, "Offset", offset, -2048, 2047) == -1) { return -1; }
+      add_bin16(asm_context, opcode | ((offset >> 1) & 0x7ff), IS_OPCODE);
+    }
+
+    return 2;
+  }
+
+  // b<!cond> skips the next instruction (offset is from pc + 4).
+  add_bin16(asm_context, (opcode ^ 0x0100), IS_OPCODE);
+
+  offset = address - (asm_context->address + 4);
+  if (check_range(asm_context, "Offset", offset, -2048, 2047) == -1) { return -1; }
+  add_bin16(asm_context, 0xe000 | ((offset >> 1) & 0x7ff), IS_OPCODE);
+
+  return 4;
+}
+
 static int read_register_list(struct _asm_context *asm_context, struct _operand *operand)
 {
   int token_type;
@@ -190,6 +263,7 @@ int parse_instruction_thumb(struct _asm_context *asm_context, char *instr)
   char instr_case[TOKENLEN];
   struct _operand operands[3];
   int operand_count = 0;
+  int known = 1;
   int matched = 0;
   int num;
   int n;
@@ -333,6 +407,8 @@ int parse_instruction_thumb(struct _asm_context *asm_context, char *instr)
         if (asm_context->pass == 1)
         {
           eat_operand(asm_context);
+          known = 0;
+          num = 0;
         }
           else
         {
@@ -666,13 +742,7 @@ int parse_instruction_thumb(struct _asm_context *asm_context, char *instr)
             // From the docs: The branch offset must take account of the
             // prefetch operation, which causes the PC to be 1 word (4 bytes)
             // ahead of the current instruction.
-            int offset = operands[0].value - (asm_context->address + 4);
-            if (asm_context->pass == 1) { offset = 0; }
-            if (check_range(asm_context, "Offset", offset, -256, 255) == -1) { return -1; }
-            if (is_2_byte_aligned(asm_context, offset) == -1) { return -1; }
-            offset >>= 1;
-            add_bin16(asm_context, table_thumb[n].opcode | (offset & 0xff), IS_OPCODE);
-            return 2;
+            return parse_branch(asm_context, operands[0].value, known, table_thumb[n].opcode, 1);
           }
           break;
         case OP_SOFTWARE_INTERRUPT:
@@ -688,16 +758,7 @@ int parse_instruction_thumb(struct _asm_context *asm_context, char *instr)
           if (operand_count == 1 &&
               operands[0].type == OPERAND_ADDRESS)
           {
-            // From the docs: The branch offset must take account of the
-            // prefetch operation, which causes the PC to be 1 word (4 bytes)
-            // ahead of the current instruction.
-            int offset = operands[0].value - (asm_context->address + 4);
-            if (asm_context->pass == 1) { offset = 0; }
-            if (check_range(asm_context, "Offset", offset, -2048, 2047) == -1) { return -1; }
-            if (is_2_byte_aligned(asm_context, offset) == -1) { return -1; }
-            offset >>= 1;
-            add_bin16(asm_context, table_thumb[n].opcode | (offset & 0x7ff), IS_OPCODE);
-            return 2;
+            return parse_branch(asm_context, operands[0].value, known, table_thumb[n].opcode, 0);
           }
           break;
         case OP_LONG_BRANCH_WITH_LINK:
@@ -19,8 +19,13 @@
 #include "common/assembler.h"
 #include "common/tokens.h"
 #include "common/eval_expression.h"
+#include "common/print_error.h"
+#include "common/relax.h"
 #include "table/z80.h"
 
+// .jump_policy speed picks j forms by their taken cycles.
+#define JUMP_SPEED 1
+
 // http://wikiti.brandonw.net/index.php?title=Z80_Instruction_Set
 // http://map.grauw.nl/resources/z80instr.php
 
@@ -89,6 +94,20 @@ enum
   REG_R,
 };
 
+// Forms the j pseudo instruction can be given.
+enum
+{
+  JUMP_JR,
+  JUMP_JP,
+};
+
+// Forms djnz can be given after .relax.
+enum
+{
+  DJNZ_SHORT,
+  DJNZ_DEC_JP,
+};
+
 enum
 {
   COND_NZ,
@@ -264,6 +283,141 @@ static int check_bit(struct _asm_context *asm_context, struct _operand *operand)
 }
 
 
+static struct _table_z80 *find_table_z80(int instr_enum, int type)
+{
+  int n = 0;
+
+  while(table_z80[n].instr_enum != Z80_NONE)
+  {
+    if (table_z80[n].instr_enum == instr_enum && table_z80[n].type == type)
+    {
+      return &table_z80[n];
+    }
+
+    n++;
+  }
+
+  return NULL;
+}
+
+static int write_jump(struct _asm_context *asm_context, int cond, int address, int known)
+{
+  struct _table_z80 *jr;
+  struct _table_z80 *jp;
+  int offset = address - (asm_context->address + 2);
+  int wanted;
+
+  if (cond == -1)
+  {
+    jr = find_table_z80(Z80_JR, OP_OFFSET8);
+    jp = find_table_z80(Z80_JP, OP_ADDRESS);
+  }
+    else
+  {
+    jr = find_table_z80(Z80_JR, OP_JR_COND_ADDRESS);
+    jp = find_table_z80(Z80_JP, OP_COND_ADDRESS);
+  }
+
+  if (cond >= COND_PO)
+  {
+    // jr only has nz, z, nc and c.
+    wanted = JUMP_JP;
+  }
+    else
+  if ((asm_context->extra_context & JUMP_SPEED) != 0 &&
+      jp->cycles_max < jr->cycles_max)
+  {
+    wanted = JUMP_JP;
+  }
+    else
+  if (known == 0)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  {
+    wanted = (offset >= -128 && offset <= 127) ? JUMP_JR : JUMP_JP;
+  }
+
+  if (relax_form(asm_context, wanted) == JUMP_JR)
+  {
+    if (asm_context->pass == 1) { offset = 0; }
+
+    add_bin8(asm_context, jr->opcode | (cond == -1 ? 0 : cond << 3), IS_OPCODE);
+    add_bin8(asm_context, offset & 0xff, IS_OPCODE);
+
+    return 2;
+  }
+
+  add_bin8(asm_context, jp->opcode | (cond == -1 ? 0 : cond << 3), IS_OPCODE);
+  add_bin8(asm_context, address & 0xff, IS_OPCODE);
+  add_bin8(asm_context, (address >> 8) & 0xff, IS_OPCODE);
+
+  return 3;
+}
+
+static int write_djnz(struct _asm_context *asm_context, int address, int known)
+{
+  int offset = address - (asm_context->address + 2);
+  int wanted;
+
+  if (known == 0)
+  {
+    wanted = RELAX_UNKNOWN;
+  }
+    else
+  {
+    wanted = (offset >= -128 && offset <= 127) ? DJNZ_SHORT : DJNZ_DEC_JP;
+  }
+
+  if (relax_form(asm_context, wanted) == DJNZ_SHORT)
+  {
+    if (asm_context->pass == 1) { offset = 0; }
+
+    add_bin8(asm_context, 0x10, IS_OPCODE);
+    add_bin8(asm_context, offset & 0xff, IS_OPCODE);
+
+    return 2;
+  }
+
+  // dec b, jp nz, address
+  add_bin8(asm_context, 0x05, IS_OPCODE);
+  add_bin8(asm_context, 0xc2, IS_OPCODE);
+  add_bin8(asm_context, address & 0xff, IS_OPCODE);
+  add_bin8(asm_context, (address >> 8) & 0xff, IS_OPCODE);
+
+  return 4;
+}
+
+int parse_directive_z80(struct _asm_context *asm_context, const char *directive)
+{
+  char token[TOKENLEN];
+
+  if (strcasecmp(directive, "jump_policy") == 0)
+  {
+    tokens_get(asm_context, token, TOKENLEN);
+
+    if (strcasecmp(token, "size") == 0)
+    {
+      asm_context->extra_context &= ~JUMP_SPEED;
+    }
+      else
+    if (strcasecmp(token, "speed") == 0)
+    {
+      asm_context->extra_context |= JUMP_SPEED;
+    }
+      else
+    {
+      print_error("jump_policy expects size or speed", asm_context);
+      return -1;
+    }
+
+    return 0;
+  }
+
+  return 1;
+}
+
 int parse_instruction_z80(struct _asm_context *asm_context, char *instr)
 {
 char token[TOKENLEN];
@@ -273,6 +427,7 @@ struct _operand operands[3];
 int operand_count=0;
 int offset=0;
 int matched=0;
+int known=1;
 int instr_enum;
 int num;
 int n,reg;
@@ -449,6 +604,7 @@ int n,reg;
         if (asm_context->pass == 1)
         {
           eat_operand(asm_context);
+          known = 0;
           num = 0;
         }
           else
@@ -487,6 +643,44 @@ printf("-- %d %d %d\n", operands[n].type, operands[n].value, operands[n].offset)
 }
 #endif
 
+  // j is jr when it reaches and jp otherwise.
+  if (instr_enum == Z80_J)
+  {
+    int cond = -1;
+
+    if (operand_count == 2 &&
+        operands[0].type == OPERAND_REG8 &&
+        operands[0].value == REG_C)
+    {
+      operands[0].type = OPERAND_COND;
+      operands[0].value = COND_C;
+    }
+
+    if (operand_count == 2 && operands[0].type == OPERAND_COND)
+    {
+      cond = operands[0].value;
+      operands[0] = operands[1];
+      operand_count = 1;
+    }
+
+    if (operand_count != 1 || operands[0].type != OPERAND_NUMBER)
+    {
+      print_error_unknown_operand_combo(instr, asm_context);
+      return -1;
+    }
+
+    return write_jump(asm_context, cond, operands[0].value, known);
+  }
+
+  // After .relax a djnz that doesn't reach becomes dec b, jp nz.
+  if (instr_enum == Z80_DJNZ &&
+      asm_context->relax.enabled == 1 &&
+      operand_count == 1 &&
+      operands[0].type == OPERAND_NUMBER)
+  {
+    return write_djnz(asm_context, operands[0].value, known);
+  }
+
   // Instruction is parsed, now find matching opcode
 
   n = 0;
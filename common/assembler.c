@@ -40,9 +40,13 @@
 #include "common/eval_expression.h"
 #include "common/tokens.h"
 #include "common/ifdef_expression.h"
+#include "common/listing.h"
+#include "common/literals.h"
 #include "common/macros.h"
+#include "common/names.h"
 #include "common/symbols.h"
 #include "common/print_error.h"
+#include "common/relax.h"
 #include "disasm/6502.h"
 #include "disasm/6800.h"
 #include "disasm/6809.h"
@@ -86,6 +90,9 @@ static int parse_org(struct _asm_context *asm_context)
     return -1;
   }
 
+  // Anything waiting for a literal pool goes at the end of the section.
+  if (literals_flush(asm_context) != 0) { return -1; }
+
   asm_context->address = num * asm_context->bytes_per_address;
 
   return 0;
@@ -217,7 +224,28 @@ static int parse_set(struct _asm_context *asm_context)
     return -1;
   }
 
-  if (expect_token(asm_context, '=') != 0) { return -1; }
+  token_type = tokens_get(asm_context, token, TOKENLEN);
+
+  // .set <option> without a value is a CPU option (MIPS .set reorder).
+  if (token_type == TOKEN_EOL || token_type == TOKEN_EOF)
+  {
+    tokens_push(asm_context, token, token_type);
+
+    if (asm_context->parse_directive != NULL &&
+        asm_context->parse_directive(asm_context, name) == 0)
+    {
+      return 0;
+    }
+
+    printf("Error: Unknown .set option '%s' at %s:%d.\n", name, asm_context->filename, asm_context->line);
+    return -1;
+  }
+
+  if (IS_NOT_TOKEN(token,'='))
+  {
+    print_error_unexp(token, asm_context);
+    return -1;
+  }
 
   if (eval_expression(asm_context, &num) == -1)
   {
@@ -320,20 +348,27 @@ void assembler_init(struct _asm_context *asm_context)
   configure_cpu(asm_context, 0);
 #endif
   asm_context->address = 0;
+  asm_context->label_address = -1;
   asm_context->instruction_count = 0;
   asm_context->code_count = 0;
   asm_context->data_count = 0;
   asm_context->ifdef_count = 0;
   asm_context->parsing_ifdef = 0;
   asm_context->bytes_per_address = 1;
+  asm_context->extra_context = 0;
 
   macros_free(&asm_context->macros);
+  literals_reset(&asm_context->literals, asm_context->pass);
+  relax_reset(&asm_context->relax);
   asm_context->def_param_stack_count = 0;
 
+  assembler_set_cpu_data(asm_context, NULL, NULL);
+
   if (asm_context->pass == 1)
   {
     // FIXME - probably need to allow 32 bit data
     //memory_init(&asm_context->memory, 1<<25, 1);
+    memory_free(&asm_context->memory);
     memory_init(&asm_context->memory, ~((uint32_t)0), 1);
   }
 }
@@ -343,6 +378,31 @@ void assembler_free(struct _asm_context *asm_context)
   symbols_free(&asm_context->symbols);
   macros_free(&asm_context->macros);
   memory_free(&asm_context->memory);
+  listing_free(&asm_context->listing);
+  literals_free(&asm_context->literals);
+  relax_free(&asm_context->relax);
+  assembler_set_cpu_data(asm_context, NULL, NULL);
+  names_free(&asm_context->names);
+}
+
+// Returns the CPU state only if it belongs to the backend that frees it
+// with cpu_data_free, so a .cpu change doesn't hand out another's state.
+void *assembler_get_cpu_data(struct _asm_context *asm_context, cpu_data_free_t cpu_data_free)
+{
+  if (asm_context->cpu_data_free != cpu_data_free) { return NULL; }
+
+  return asm_context->cpu_data;
+}
+
+void assembler_set_cpu_data(struct _asm_context *asm_context, void *cpu_data, cpu_data_free_t cpu_data_free)
+{
+  if (asm_context->cpu_data_free != NULL)
+  {
+    asm_context->cpu_data_free(asm_context->cpu_data);
+  }
+
+  asm_context->cpu_data = cpu_data;
+  asm_context->cpu_data_free = cpu_data_free;
 }
 
 void assembler_print_info(struct _asm_context *asm_context, FILE *out)
@@ -385,6 +445,27 @@ void assembler_print_info(struct _asm_context *asm_context, FILE *out)
   fprintf(out, " Instructions: %d\n", asm_context->instruction_count);
   fprintf(out, "   Code Bytes: %d\n", asm_context->code_count);
   fprintf(out, "   Data Bytes: %d\n", asm_context->data_count);
+
+  if (asm_context->relax.passes != 0)
+  {
+    fprintf(out, " Relax Passes: %d\n", asm_context->relax.passes);
+  }
+
+  if (asm_context->relax.shortened != 0)
+  {
+    fprintf(out, "    Shortened: %d\n", asm_context->relax.shortened);
+  }
+
+  if (asm_context->relax.saved != 0)
+  {
+    fprintf(out, "  Words Saved: %d\n", asm_context->relax.saved);
+  }
+
+  if (asm_context->relax.delay_slots != 0)
+  {
+    fprintf(out, "Delay Slots Filled: %d\n", asm_context->relax.delay_slots);
+  }
+
   fprintf(out, "  Low Address: %04x (%d)\n",
     asm_context->memory.low_address / asm_context->bytes_per_address,
     asm_context->memory.low_address / asm_context->bytes_per_address);
@@ -519,7 +600,7 @@ int check_for_directive(struct _asm_context *asm_context, char *token)
     if (asm_context->pass == 2 && asm_context->list != NULL)
     {
       asm_context->write_list_file = 1;
-      putc('\n', asm_context->list);
+      listing_source_char(&asm_context->listing, '\n');
     }
     return 1;
   }
@@ -591,17 +672,6 @@ int check_for_directive(struct _asm_context *asm_context, char *token)
     {
       configure_cpu(asm_context, n);
 
-#if 0
-      if (strcmp(token, "65816") == 0)
-      {
-        asm_context->parse_directive = parse_directive_65816;
-      }
-        else
-#endif
-      {
-        asm_context->parse_directive = NULL;
-      }
-
       return 1;
     }
     n++;
@@ -641,6 +711,8 @@ int assemble(struct _asm_context *asm_context)
       {
         return -1;
       }
+
+      asm_context->label_address = asm_context->address;
     }
       else
     if (token_type == TOKEN_POUND || IS_TOKEN(token,'.'))
@@ -716,6 +788,16 @@ int assemble(struct _asm_context *asm_context)
         asm_context->msp430_cpu4 = 1;
       }
         else
+      if (strcasecmp(token, "relax") == 0)
+      {
+        asm_context->relax.enabled = 1;
+      }
+        else
+      if (strcasecmp(token, "norelax") == 0)
+      {
+        asm_context->relax.enabled = 0;
+      }
+        else
       if (strcasecmp(token, "macro") == 0)
       {
         if (macros_parse(asm_context, IS_MACRO) != 0) return -1;
@@ -808,8 +890,10 @@ int assemble(struct _asm_context *asm_context)
 
           if (asm_context->list != NULL && asm_context->write_list_file == 1)
           {
-            asm_context->list_output(asm_context, start_address, asm_context->address);
-            fprintf(asm_context->list, "\n");
+            if (listing_append(asm_context, start_address, asm_context->address) != 0)
+            {
+              return -1;
+            }
           }
 
           if (ret < 0) return -1;
@@ -836,3 +920,53 @@ int assemble(struct _asm_context *asm_context)
   return 0;
 }
 
+int assembler_end_pass(struct _asm_context *asm_context)
+{
+  // Called once the top level file is done (assemble() also returns at
+  // the end of every include file).
+  if (literals_flush(asm_context) != 0) { return -1; }
+
+  return 0;
+}
+
+int assembler_relax(struct _asm_context *asm_context)
+{
+  struct _symbols *symbols = &asm_context->symbols;
+  int error_flag = 0;
+
+  // Pass 1 is repeated with the labels from the last time through so
+  // instructions with more than one size can pick the smallest that
+  // reaches.  Nothing to do unless a relaxed instruction asked for it.
+  asm_context->relax.passes = 0;
+  symbols->moved = 0;
+
+  while(asm_context->relax.changed != 0 || symbols->moved != 0)
+  {
+    if (asm_context->relax.passes == RELAX_MAX_PASSES)
+    {
+      printf("Error: Instruction sizes didn't settle after %d passes.\n",
+        RELAX_MAX_PASSES);
+      error_flag = -1;
+      break;
+    }
+
+    symbols_scope_reset(symbols);
+    symbols->redefine = 1;
+    symbols->moved = 0;
+
+    asm_context->pass = 1;
+    assembler_init(asm_context);
+
+    error_flag = assemble(asm_context);
+    if (error_flag == 0) { error_flag = assembler_end_pass(asm_context); }
+
+    asm_context->relax.passes++;
+
+    if (error_flag != 0) { break; }
+  }
+
+  symbols->redefine = 0;
+
+  return error_flag;
+}
+
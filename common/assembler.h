@@ -15,10 +15,14 @@
 #include <stdio.h>
 
 #include "common/cpu_list.h"
+#include "common/listing.h"
+#include "common/literals.h"
 #include "common/macros.h"
 #include "common/memory.h"
 #include "common/memory_pool.h"
+#include "common/names.h"
 #include "common/print_error.h"
+#include "common/relax.h"
 #include "common/symbols.h"
 #include "common/tokens.h"
 
@@ -33,16 +37,25 @@
 #define SEGMENT_CODE 0
 #define SEGMENT_BSS 1
 
+// State a CPU keeps between instructions that won't fit in extra_context.
+// The backend allocates it, and it's freed at the start of every pass.
+typedef void (*cpu_data_free_t)(void *);
+
 struct _asm_context
 {
   FILE *list;
+  struct _listing listing;
+  struct _literals literals;
+  struct _relax relax;
   struct _memory memory;
   struct _symbols symbols;
   struct _macros macros;
+  struct _names names;
   parse_instruction_t parse_instruction;
   parse_directive_t parse_directive;
   list_output_t list_output;
   int address;
+  int label_address;
   int segment;
   int line;
   int pass;
@@ -84,13 +97,19 @@ struct _asm_context
   uint8_t dump_macros : 1;
   uint32_t flags;
   uint32_t extra_context;
+  void *cpu_data;
+  cpu_data_free_t cpu_data_free;
 };
 
 int add_to_include_path(struct _asm_context *asm_context, char *paths);
 void assembler_init(struct _asm_context *asm_context);
 void assembler_free(struct _asm_context *asm_context);
+void *assembler_get_cpu_data(struct _asm_context *asm_context, cpu_data_free_t cpu_data_free);
+void assembler_set_cpu_data(struct _asm_context *asm_context, void *cpu_data, cpu_data_free_t cpu_data_free);
 void assembler_print_info(struct _asm_context *asm_context, FILE *out);
 int assemble(struct _asm_context *asm_context);
+int assembler_end_pass(struct _asm_context *asm_context);
+int assembler_relax(struct _asm_context *asm_context);
 
 #endif
 
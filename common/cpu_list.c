@@ -88,13 +88,13 @@ struct _cpu_list cpu_list[] =
   { "6502", CPU_TYPE_6502, ENDIAN_LITTLE, 1, ALIGN_1, 1, 0, 1, SREC_16, parse_instruction_6502, NULL, list_output_6502, disasm_range_6502, simulate_init_6502, NO_FLAGS },
 #endif
 #ifdef ENABLE_65816
-  { "65816", CPU_TYPE_65816, ENDIAN_LITTLE, 1, ALIGN_1, 1, 0, 1, SREC_16, parse_instruction_65816, NULL, list_output_65816, disasm_range_65816, simulate_init_65816, NO_FLAGS },
+  { "65816", CPU_TYPE_65816, ENDIAN_LITTLE, 1, ALIGN_1, 1, 0, 1, SREC_16, parse_instruction_65816, parse_directive_65816, list_output_65816, disasm_range_65816, simulate_init_65816, NO_FLAGS },
 #endif
 #ifdef ENABLE_6800
   { "6800", CPU_TYPE_6800, ENDIAN_BIG, 1, ALIGN_1, 1, 0, 0, SREC_16, parse_instruction_6800, NULL, list_output_6800, disasm_range_6800, NULL, NO_FLAGS },
 #endif
 #ifdef ENABLE_6809
-  { "6809", CPU_TYPE_6809, ENDIAN_BIG, 1, ALIGN_1, 1, 0, 0, SREC_16, parse_instruction_6809, NULL, list_output_6809, disasm_range_6809, NULL, NO_FLAGS },
+  { "6809", CPU_TYPE_6809, ENDIAN_BIG, 1, ALIGN_1, 1, 0, 0, SREC_16, parse_instruction_6809, parse_directive_6809, list_output_6809, disasm_range_6809, NULL, NO_FLAGS },
 #endif
 #ifdef ENABLE_68HC08
   { "68hc08", CPU_TYPE_68HC08, ENDIAN_BIG, 1, ALIGN_1, 1, 0, 0, SREC_16, parse_instruction_68hc08, NULL, list_output_68hc08, disasm_range_68hc08, NULL, NO_FLAGS },
@@ -109,10 +109,10 @@ struct _cpu_list cpu_list[] =
   { "arc", CPU_TYPE_ARC, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_arc, NULL, list_output_arc, disasm_range_arc, NULL, NO_FLAGS },
 #endif
 #ifdef ENABLE_ARM
-  { "arm", CPU_TYPE_ARM, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_arm, NULL, list_output_arm, disasm_range_arm, NULL, NO_FLAGS },
+  { "arm", CPU_TYPE_ARM, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_arm, parse_directive_arm, list_output_arm, disasm_range_arm, NULL, NO_FLAGS },
 #endif
 #ifdef ENABLE_AVR8
-  { "avr8", CPU_TYPE_AVR8, ENDIAN_LITTLE, 2, ALIGN_2, 0, 0, 0, SREC_16, parse_instruction_avr8, NULL, list_output_avr8, disasm_range_avr8, simulate_init_avr8, NO_FLAGS },
+  { "avr8", CPU_TYPE_AVR8, ENDIAN_LITTLE, 2, ALIGN_2, 0, 0, 0, SREC_16, parse_instruction_avr8, parse_directive_avr8, list_output_avr8, disasm_range_avr8, simulate_init_avr8, NO_FLAGS },
 #endif
 #ifdef ENABLE_CELL
   { "cell", CPU_TYPE_CELL, ENDIAN_BIG, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_cell, NULL, list_output_cell, disasm_range_cell, NULL, NO_FLAGS },
@@ -127,17 +127,17 @@ struct _cpu_list cpu_list[] =
   { "lc3", CPU_TYPE_LC3, ENDIAN_BIG, 2, ALIGN_2, 0, 0, 0, SREC_16, parse_instruction_lc3, NULL, list_output_lc3, disasm_range_lc3,  simulate_init_lc3, NO_FLAGS },
 #endif
 #ifdef ENABLE_MIPS
-  { "mips", CPU_TYPE_MIPS32, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_mips, NULL, list_output_mips, disasm_range_mips, simulate_init_mips, MIPS_I | MIPS_II | MIPS_III },
-  { "mips32", CPU_TYPE_MIPS32, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_mips, NULL, list_output_mips, disasm_range_mips, simulate_init_mips, MIPS_I | MIPS_II | MIPS_III | MIPS_FPU | MIPS_MSA },
-  { "pic32", CPU_TYPE_MIPS32, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_mips, NULL, list_output_mips, disasm_range_mips, simulate_init_mips, MIPS_I | MIPS_II | MIPS_III | MIPS_32 },
-  { "ps2_ee", CPU_TYPE_EMOTION_ENGINE, ENDIAN_LITTLE, 1, ALIGN_16, 0, 0, 0, SREC_32, parse_instruction_mips, NULL, list_output_mips, disasm_range_mips, simulate_init_mips, MIPS_I | MIPS_II | MIPS_III | MIPS_IV | MIPS_FPU | MIPS_EE_CORE | MIPS_EE_VU },
+  { "mips", CPU_TYPE_MIPS32, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_mips, parse_directive_mips, list_output_mips, disasm_range_mips, simulate_init_mips, MIPS_I | MIPS_II | MIPS_III },
+  { "mips32", CPU_TYPE_MIPS32, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_mips, parse_directive_mips, list_output_mips, disasm_range_mips, simulate_init_mips, MIPS_I | MIPS_II | MIPS_III | MIPS_FPU | MIPS_MSA },
+  { "pic32", CPU_TYPE_MIPS32, ENDIAN_LITTLE, 1, ALIGN_4, 0, 0, 0, SREC_32, parse_instruction_mips, parse_directive_mips, list_output_mips, disasm_range_mips, simulate_init_mips, MIPS_I | MIPS_II | MIPS_III | MIPS_32 },
+  { "ps2_ee", CPU_TYPE_EMOTION_ENGINE, ENDIAN_LITTLE, 1, ALIGN_16, 0, 0, 0, SREC_32, parse_instruction_mips, parse_directive_mips, list_output_mips, disasm_range_mips, simulate_init_mips, MIPS_I | MIPS_II | MIPS_III | MIPS_IV | MIPS_FPU | MIPS_EE_CORE | MIPS_EE_VU },
 #endif
 #ifdef ENABLE_MSP430
   { "msp430", CPU_TYPE_MSP430, ENDIAN_LITTLE, 1, ALIGN_2, 0, 0, 1, SREC_16, parse_instruction_msp430, NULL, list_output_msp430, disasm_range_msp430, simulate_init_msp430, NO_FLAGS },
   { "msp430x", CPU_TYPE_MSP430X, ENDIAN_LITTLE, 1, ALIGN_2, 0, 0, 1, SREC_24, parse_instruction_msp430, NULL, list_output_msp430x, disasm_range_msp430x, simulate_init_msp430, NO_FLAGS },
 #endif
 #ifdef ENABLE_PIC14
-  { "pic14", CPU_TYPE_PIC14, ENDIAN_LITTLE, 2, ALIGN_2, 0, 0, 0, SREC_16, parse_instruction_pic14, NULL, list_output_pic14, disasm_range_pic14, NULL, NO_FLAGS },
+  { "pic14", CPU_TYPE_PIC14, ENDIAN_LITTLE, 2, ALIGN_2, 0, 0, 0, SREC_16, parse_instruction_pic14, parse_directive_pic14, list_output_pic14, disasm_range_pic14, NULL, NO_FLAGS },
 #endif
 #ifdef ENABLE_DSPIC
   { "pic24", CPU_TYPE_PIC24, ENDIAN_LITTLE, 2, ALIGN_2, 0, 0, 0, SREC_24, parse_instruction_dspic, NULL, list_output_dspic, disasm_range_dspic, NULL, NO_FLAGS },
@@ -172,7 +172,7 @@ struct _cpu_list cpu_list[] =
   { "tms9900", CPU_TYPE_TMS9900, ENDIAN_BIG, 1, ALIGN_2, 0, 0, 0, SREC_16, parse_instruction_tms9900, NULL, list_output_tms9900, disasm_range_tms9900, simulate_init_tms9900, NO_FLAGS },
 #endif
 #ifdef ENABLE_Z80
-  { "z80", CPU_TYPE_Z80, ENDIAN_LITTLE, 1, ALIGN_1, 0, 1, 0, SREC_16, parse_instruction_z80, NULL, list_output_z80, disasm_range_z80, simulate_init_z80, NO_FLAGS },
+  { "z80", CPU_TYPE_Z80, ENDIAN_LITTLE, 1, ALIGN_1, 0, 1, 0, SREC_16, parse_instruction_z80, parse_directive_z80, list_output_z80, disasm_range_z80, simulate_init_z80, NO_FLAGS },
 #endif
   { NULL },
 };
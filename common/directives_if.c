@@ -103,7 +103,7 @@ int parse_ifdef(struct _asm_context *asm_context, int ifndef)
   }
 
   if (macros_lookup(&asm_context->macros, token, &param_count) != NULL ||
-      symbols_find(&asm_context->symbols, token) != NULL)
+      symbols_find(&asm_context->symbols, token) != -1)
   {
     if (ifndef == 1) ignore_section = 1;
   }
@@ -317,9 +317,9 @@ printf("Paren got back %d\n", paren_num);
       break;
     }
 
-    // End of expression
+    // End of expression (@ is for suffixes like PowerPC's label@ha)
     if (IS_TOKEN(token,',') || IS_TOKEN(token,']') || token_type == TOKEN_EOF ||
-        IS_TOKEN(token,'.'))
+        IS_TOKEN(token,'.') || IS_TOKEN(token,'@'))
     {
       tokens_push(asm_context, token, token_type);
       break;
@@ -114,7 +114,7 @@ int ret;
   if (macros_lookup(&asm_context->macros, token, &param_count) != NULL)
   { ret = 1; }
     else
-  if (symbols_find(&asm_context->symbols, token) != NULL)
+  if (symbols_find(&asm_context->symbols, token) != -1)
   { ret = 1; }
     else
   { ret = 0; }
@@ -168,7 +168,7 @@ static int parse_ifdef_expression(struct _asm_context *asm_context, int *num, in
 {
 char token[TOKENLEN];
 struct _operator operator;
-struct _symbols_data *symbols_data;
+int index;
 int token_type;
 //int state=0;  // 0 = get next num to process
 int not = 0;
@@ -278,9 +278,9 @@ printf("debug> #if: parse_defined()=%d\n", n);
           if (n == -1) return -1;
         }
           else
-        if (value == NULL && (symbols_data = symbols_find(&asm_context->symbols, token)) != NULL)
+        if (value == NULL && (index = symbols_find(&asm_context->symbols, token)) != -1)
         {
-          n = symbols_data->address;
+          n = asm_context->symbols.address[index];
         }
           else
         if (value != NULL && param_count == 0 && is_num(value))
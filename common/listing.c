@@ -0,0 +1,274 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPLv3
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/assembler.h"
+#include "common/listing.h"
+#include "common/memory.h"
+
+void listing_init(struct _listing *listing)
+{
+  memset(listing, 0, sizeof(struct _listing));
+}
+
+void listing_free(struct _listing *listing)
+{
+  free(listing->records);
+  free(listing->source);
+
+  if (listing->text != NULL) { fclose(listing->text); }
+
+  memset(listing, 0, sizeof(struct _listing));
+}
+
+void listing_source_char(struct _listing *listing, int ch)
+{
+  if (listing->source_len == listing->source_alloc)
+  {
+    listing->source_alloc += LISTING_SOURCE_SIZE;
+    listing->source = realloc(listing->source, listing->source_alloc);
+  }
+
+  listing->source[listing->source_len++] = ch;
+}
+
+int listing_append(struct _asm_context *asm_context, uint32_t start, uint32_t end)
+{
+  struct _listing *listing = &asm_context->listing;
+  struct _listing_record *record;
+  FILE *list = asm_context->list;
+
+  if (listing->text == NULL)
+  {
+    listing->text = tmpfile();
+
+    if (listing->text == NULL)
+    {
+      printf("Error: Couldn't open temp file for listing.\n");
+      return -1;
+    }
+  }
+
+  if (listing->record_count == listing->record_alloc)
+  {
+    listing->record_alloc += LISTING_RECORDS_SIZE;
+    listing->records = realloc(listing->records,
+      listing->record_alloc * sizeof(struct _listing_record));
+  }
+
+  record = &listing->records[listing->record_count++];
+
+  asm_context->list = listing->text;
+  asm_context->list_output(asm_context, start, end);
+  asm_context->list = list;
+
+  record->source_end = listing->source_len;
+  record->text_end = ftell(listing->text);
+  record->shortened = asm_context->relax.shortened != listing->shortened;
+
+  listing->shortened = asm_context->relax.shortened;
+
+  return 0;
+}
+
+int listing_redo(struct _asm_context *asm_context, int count, const uint32_t *start, const uint32_t *end)
+{
+  struct _listing *listing = &asm_context->listing;
+  FILE *list = asm_context->list;
+  long position = 0;
+  int first = listing->record_count - count;
+  int n;
+
+  // For instructions that move code already listed (filling a delay slot
+  // swaps it with the branch), list the last count records again.  Any
+  // old text past the new end is written over by the next record.
+  if (list == NULL || asm_context->write_list_file == 0) { return 0; }
+  if (listing->text == NULL || first < 0) { return -1; }
+
+  if (first > 0) { position = listing->records[first - 1].text_end; }
+
+  if (fseek(listing->text, position, SEEK_SET) != 0) { return -1; }
+
+  asm_context->list = listing->text;
+
+  for (n = 0; n < count; n++)
+  {
+    asm_context->list_output(asm_context, start[n], end[n]);
+    listing->records[first + n].text_end = ftell(listing->text);
+  }
+
+  asm_context->list = list;
+
+  return 0;
+}
+
+static void output_hex_text(FILE *fp, char *s, int ptr)
+{
+  if (ptr == 0) return;
+  s[ptr] = 0;
+  int n;
+  for (n = 0; n < ((16 - ptr) * 3) + 2; n++) { putc(' ', fp); }
+  fprintf(fp, "%s", s);
+}
+
+static int compare_pages(const void *a, const void *b)
+{
+  const struct _memory_page *page_a = *(struct _memory_page * const *)a;
+  const struct _memory_page *page_b = *(struct _memory_page * const *)b;
+
+  if (page_a->address < page_b->address) { return -1; }
+  if (page_a->address > page_b->address) { return 1; }
+
+  return 0;
+}
+
+static void write_data_sections(struct _asm_context *asm_context)
+{
+  struct _memory *memory = &asm_context->memory;
+  struct _memory_page **pages;
+  struct _memory_page *page;
+  FILE *out = asm_context->list;
+  uint32_t address, start, end;
+  uint32_t next = 0;
+  int page_count = 0;
+  int ch = 0;
+  int ptr = 0;
+  char str[17];
+  int n;
+
+  fprintf(out, "data sections:");
+
+  if (memory->debug_flag == 0) { fprintf(out, "\n\n"); return; }
+
+  for (page = memory->pages; page != NULL; page = page->next) { page_count++; }
+
+  pages = malloc((page_count + 1) * sizeof(struct _memory_page *));
+
+  page_count = 0;
+  for (page = memory->pages; page != NULL; page = page->next)
+  {
+    pages[page_count++] = page;
+  }
+
+  qsort(pages, page_count, sizeof(struct _memory_page *), compare_pages);
+
+  // Only the populated part of each page is visited.  Anything between
+  // two of those ranges is empty, which ends the current data row.
+  for (n = 0; n < page_count; n++)
+  {
+    page = pages[n];
+
+    if (page->offset_min > page->offset_max) { continue; }
+
+    start = page->address + page->offset_min;
+    end = page->address + page->offset_max;
+
+    if (start < memory->low_address) { start = memory->low_address; }
+    if (end > memory->high_address) { end = memory->high_address; }
+    if (start > end) { continue; }
+
+    if (start != next)
+    {
+      output_hex_text(out, str, ptr);
+      ch = 0;
+      ptr = 0;
+    }
+
+    for (address = start; address <= end; address++)
+    {
+      if (page->debug_line[address - page->address] == DL_DATA)
+      {
+        if (ch == 0)
+        {
+          if (ptr != 0)
+          {
+            output_hex_text(out, str, ptr);
+          }
+          fprintf(out, "\n%04x:", address / asm_context->bytes_per_address);
+          ptr = 0;
+        }
+
+        unsigned char data = page->bin[address - page->address];
+        fprintf(out, " %02x", data);
+
+        if (data >= ' ' && data <= 120)
+        { str[ptr++] = data; }
+          else
+        { str[ptr++] = '.'; }
+
+        ch++;
+        if (ch == 16) { ch = 0; }
+      }
+        else
+      {
+        output_hex_text(out, str, ptr);
+        ch = 0;
+        ptr = 0;
+      }
+    }
+
+    next = end + 1;
+  }
+
+  output_hex_text(out, str, ptr);
+  fprintf(out, "\n\n");
+
+  free(pages);
+}
+
+void listing_write(struct _asm_context *asm_context)
+{
+  struct _listing *listing = &asm_context->listing;
+  struct _listing_record *record;
+  FILE *out = asm_context->list;
+  char buffer[4096];
+  uint32_t text_ptr = 0;
+  int ptr = 0;
+  int length;
+  int n;
+
+  if (listing->text != NULL) { rewind(listing->text); }
+
+  for (n = 0; n < listing->record_count; n++)
+  {
+    record = &listing->records[n];
+
+    fwrite(listing->source + ptr, 1, record->source_end - ptr, out);
+    ptr = record->source_end;
+
+    while(text_ptr < record->text_end)
+    {
+      length = record->text_end - text_ptr;
+      if (length > (int)sizeof(buffer)) { length = sizeof(buffer); }
+
+      length = fread(buffer, 1, length, listing->text);
+      if (length <= 0) { break; }
+
+      fwrite(buffer, 1, length, out);
+      text_ptr += length;
+    }
+
+    if (record->shortened == 1)
+    {
+      fprintf(out, "        (shortened)\n");
+    }
+
+    fprintf(out, "\n");
+  }
+
+  fwrite(listing->source + ptr, 1, listing->source_len - ptr, out);
+
+  write_data_sections(asm_context);
+}
+
@@ -0,0 +1,56 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPLv3
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#ifndef _LISTING_H
+#define _LISTING_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "common/cpu_list.h"
+
+#define LISTING_SOURCE_SIZE 65536
+#define LISTING_RECORDS_SIZE 1024
+
+struct _asm_context;
+
+// One of these is captured in pass 2 for every assembled instruction.
+// The disassembled text is written out to a temp file right away, while
+// memory still holds this instruction's bytes (a later .org can write
+// over them), so building the listing afterwards is only copying.
+struct _listing_record
+{
+  uint32_t source_end;     // offset into source[] up to this instruction
+  uint32_t text_end;       // offset into text up to this instruction
+  uint8_t shortened;       // relaxation made the instruction smaller
+};
+
+struct _listing
+{
+  struct _listing_record *records;
+  char *source;
+  FILE *text;
+  int record_count;
+  int record_alloc;
+  int source_len;
+  int source_alloc;
+  int shortened;           // relax shortened count at the last record
+};
+
+void listing_init(struct _listing *listing);
+void listing_free(struct _listing *listing);
+void listing_source_char(struct _listing *listing, int ch);
+int listing_append(struct _asm_context *asm_context, uint32_t start, uint32_t end);
+int listing_redo(struct _asm_context *asm_context, int count, const uint32_t *start, const uint32_t *end);
+void listing_write(struct _asm_context *asm_context);
+
+#endif
+
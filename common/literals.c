@@ -0,0 +1,177 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "common/assembler.h"
+#include "common/literals.h"
+#include "common/memory.h"
+
+void literals_init(struct _literals *literals)
+{
+  memset(literals, 0, sizeof(struct _literals));
+}
+
+void literals_free(struct _literals *literals)
+{
+  free(literals->values);
+  free(literals->pools);
+
+  memset(literals, 0, sizeof(struct _literals));
+}
+
+void literals_reset(struct _literals *literals, int pass)
+{
+  literals->count = 0;
+  literals->pool = 0;
+
+  // Pass 1 decides where the pools go.
+  if (pass == 1) { literals->pool_count = 0; }
+}
+
+int literals_add(struct _asm_context *asm_context, uint32_t value, int known, uint32_t *address)
+{
+  struct _literals *literals = &asm_context->literals;
+  struct _literal_pool *pool;
+  int n;
+
+  *address = 0;
+
+  // Constants already waiting in this pool are shared.  Values that
+  // aren't known yet (pass 1 forward references) always get their own
+  // word since they could be anything.
+  if (known == 1)
+  {
+    for (n = 0; n < literals->count; n++)
+    {
+      if (literals->values[n].known == 1 && literals->values[n].value == value)
+      {
+        break;
+      }
+    }
+  }
+    else
+  {
+    n = literals->count;
+  }
+
+  if (n == literals->count)
+  {
+    if (asm_context->pass == 2)
+    {
+      if (literals->pool >= literals->pool_count ||
+          n >= literals->pools[literals->pool].size)
+      {
+        print_error_internal(asm_context, __FILE__, __LINE__);
+        return -1;
+      }
+    }
+
+    if (literals->count == literals->alloc)
+    {
+      literals->alloc += LITERALS_ALLOC_SIZE;
+      literals->values = realloc(literals->values,
+        literals->alloc * sizeof(struct _literal));
+    }
+
+    literals->values[n].value = value;
+    literals->values[n].known = known;
+    literals->count++;
+  }
+
+  if (asm_context->pass == 2)
+  {
+    pool = &literals->pools[literals->pool];
+    *address = pool->address + (n * 4);
+  }
+
+  return 0;
+}
+
+static void literals_write32(struct _asm_context *asm_context, uint32_t data)
+{
+  if (asm_context->memory.endian == ENDIAN_LITTLE)
+  {
+    memory_write_inc(asm_context, data & 0xff, DL_DATA);
+    memory_write_inc(asm_context, (data >> 8) & 0xff, DL_DATA);
+    memory_write_inc(asm_context, (data >> 16) & 0xff, DL_DATA);
+    memory_write_inc(asm_context, (data >> 24) & 0xff, DL_DATA);
+  }
+    else
+  {
+    memory_write_inc(asm_context, (data >> 24) & 0xff, DL_DATA);
+    memory_write_inc(asm_context, (data >> 16) & 0xff, DL_DATA);
+    memory_write_inc(asm_context, (data >> 8) & 0xff, DL_DATA);
+    memory_write_inc(asm_context, data & 0xff, DL_DATA);
+  }
+
+  asm_context->data_count += 4;
+}
+
+int literals_flush(struct _asm_context *asm_context)
+{
+  struct _literals *literals = &asm_context->literals;
+  struct _literal_pool *pool;
+  int n;
+
+  // Every flush is a pool (even an empty one) so pass 2 can match them
+  // up with pass 1 by position.
+  if (asm_context->pass == 1)
+  {
+    if (literals->pool_count == literals->pool_alloc)
+    {
+      literals->pool_alloc += LITERALS_ALLOC_SIZE;
+      literals->pools = realloc(literals->pools,
+        literals->pool_alloc * sizeof(struct _literal_pool));
+    }
+
+    pool = &literals->pools[literals->pool_count++];
+    pool->size = literals->count;
+  }
+    else
+  {
+    if (literals->pool >= literals->pool_count)
+    {
+      print_error_internal(asm_context, __FILE__, __LINE__);
+      return -1;
+    }
+
+    pool = &literals->pools[literals->pool];
+  }
+
+  if (pool->size != 0)
+  {
+    while((asm_context->address & 3) != 0)
+    {
+      memory_write_inc(asm_context, 0, DL_DATA);
+      asm_context->data_count++;
+    }
+
+    if (asm_context->pass == 1) { pool->address = asm_context->address; }
+
+    // In pass 2 a value that turned out to fit in an instruction leaves
+    // its word unused so everything after the pool stays put.
+    for (n = 0; n < pool->size; n++)
+    {
+      literals_write32(asm_context,
+        n < literals->count ? literals->values[n].value : 0);
+    }
+  }
+
+  literals->count = 0;
+  literals->pool++;
+
+  return 0;
+}
+
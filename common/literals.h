@@ -0,0 +1,53 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#ifndef _LITERALS_H
+#define _LITERALS_H
+
+#include <stdint.h>
+
+#define LITERALS_ALLOC_SIZE 64
+
+struct _asm_context;
+
+struct _literal
+{
+  uint32_t value;
+  uint8_t known;
+};
+
+// Where each pool went in pass 1 and how many words it reserved.  Pass 2
+// places the same pools at the same addresses so no labels move.
+struct _literal_pool
+{
+  uint32_t address;
+  int size;
+};
+
+struct _literals
+{
+  struct _literal *values;        // values waiting for the current pool
+  struct _literal_pool *pools;
+  int count;
+  int alloc;
+  int pool;                       // index of the current pool this pass
+  int pool_count;
+  int pool_alloc;
+};
+
+void literals_init(struct _literals *literals);
+void literals_free(struct _literals *literals);
+void literals_reset(struct _literals *literals, int pass);
+int literals_add(struct _asm_context *asm_context, uint32_t value, int known, uint32_t *address);
+int literals_flush(struct _asm_context *asm_context);
+
+#endif
+
@@ -16,6 +16,7 @@
 #include "common/assembler.h"
 #include "common/macros.h"
 #include "common/memory_pool.h"
+#include "common/names.h"
 #include "common/symbols.h"
 #include "common/tokens.h"
 
@@ -83,6 +84,12 @@ static int macros_parse_token(struct _asm_context *asm_context, char *token, int
   return 0;
 }
 
+// Entries are padded so name_id stays 4 byte aligned.
+static int macro_data_size(int value_len)
+{
+  return (sizeof(struct _macro_data) + value_len + 3) & ~3;
+}
+
 // Note to self: This is not the best way to take care of this.
 static int check_endm(char *macro, int ptr)
 {
@@ -111,8 +118,9 @@ static int check_endm(char *macro, int ptr)
   return 0;
 }
 
-int macros_init(struct _macros *macros)
+int macros_init(struct _macros *macros, struct _names *names)
 {
+  macros->names = names;
   macros->memory_pool = NULL;
   macros->locked = 0;
 
@@ -130,32 +138,30 @@ int macros_append(struct _asm_context *asm_context, char *name, char *value, int
 {
   struct _macros *macros = &asm_context->macros;
   struct _memory_pool *memory_pool = macros->memory_pool;
-  uint32_t address;
+  uint32_t name_id;
   int param_count_temp;
-  int name_len;
   int value_len;
+  int size;
 
   if (macros->locked == 1) { return 0; }
 
-  if (macros_lookup(macros, name, &param_count_temp) != NULL ||
-      symbols_lookup(&asm_context->symbols, name, &address) == 0)
-  {
-    printf("Error: Macro '%s' already defined.\n", name);
-    return -1;
-  }
-
-  name_len = strlen(name) + 1;
   value_len = strlen(value) + 1;
 
-  // The name of the macro can only be 255 chars
-  if (name_len > 255)
+  name_id = names_intern(macros->names, name);
+
+  if (name_id == NAME_NONE) { return -1; }
+
+  if (macros_lookup_id(macros, name_id, &param_count_temp) != NULL ||
+      symbols_find_id(&asm_context->symbols, name_id) != -1)
   {
-    printf("Error: Macro name '%s' is too big.\n", name);
+    printf("Error: Macro '%s' already defined.\n", name);
     return -1;
   }
 
+  size = macro_data_size(value_len);
+
   // Check the size of the new macro against the size of a pool.
-  if (name_len + value_len + sizeof(struct _macro_data) > MACROS_HEAP_SIZE)
+  if (size > MACROS_HEAP_SIZE)
   {
     printf("Error: Macro '%s' is too big.\n", name);
     return -1;
@@ -171,7 +177,7 @@ int macros_append(struct _asm_context *asm_context, char *name, char *value, int
   // If none can be found, alloc a new one.
   while(1)
   {
-     if (memory_pool->ptr + name_len + value_len + sizeof(struct _macro_data) < memory_pool->len)
+     if (memory_pool->ptr + size < memory_pool->len)
      {
        break;
      }
@@ -185,15 +191,13 @@ int macros_append(struct _asm_context *asm_context, char *name, char *value, int
   }
 
   // Set the new macro entry.
-  // FIXME - probably should align by 4 for RISC machines.
   struct _macro_data *macro_data =
     (struct _macro_data *)(memory_pool->buffer + memory_pool->ptr);
+  macro_data->name_id = name_id;
   macro_data->param_count = (uint8_t)param_count;
-  macro_data->name_len = name_len;
   macro_data->value_len = value_len;
-  memcpy(macro_data->data, name, name_len);
-  memcpy(macro_data->data + name_len, value, value_len);
-  memory_pool->ptr += name_len + value_len + sizeof(struct _macro_data);
+  memcpy(macro_data->value, value, value_len);
+  memory_pool->ptr += size;
 
   return 0;
 } 
@@ -204,9 +208,21 @@ void macros_lock(struct _macros *macros)
 }
 
 char *macros_lookup(struct _macros *macros, char *name, int *param_count)
+{
+  uint32_t name_id;
+
+  if (macros->memory_pool == NULL) { return NULL; }
+
+  name_id = names_find(macros->names, name);
+
+  if (name_id == NAME_NONE) { return NULL; }
+
+  return macros_lookup_id(macros, name_id, param_count);
+}
+
+char *macros_lookup_id(struct _macros *macros, uint32_t name_id, int *param_count)
 {
   struct _memory_pool *memory_pool = macros->memory_pool;
-  char *value;
   int ptr;
 
   while(memory_pool != NULL)
@@ -216,16 +232,14 @@ char *macros_lookup(struct _macros *macros, char *name, int *param_count)
     {
       struct _macro_data *macro_data =
         (struct _macro_data *)(memory_pool->buffer + ptr);
-      //name_len = strlen((char *)memory_pool->buffer+ptr) + 1;
-      //value_len = strlen((char *)memory_pool->buffer + ptr + name_len) + 1;
 
-      if (strcmp(macro_data->data, name) == 0)
+      if (macro_data->name_id == name_id)
       {
-        value = macro_data->data + macro_data->name_len;
         *param_count = macro_data->param_count;
-        return value;
+        return macro_data->value;
       }
-      ptr += macro_data->name_len + macro_data->value_len + sizeof(struct _macro_data);
+
+      ptr += macro_data_size(macro_data->value_len);
     }
 
     memory_pool = memory_pool->next;
@@ -253,10 +267,10 @@ int macros_iterate(struct _macros *macros, struct _macros_iter *iter)
         (struct _macro_data *)(memory_pool->buffer + iter->ptr);
 
       iter->param_count = macro_data->param_count;
-      iter->name = macro_data->data;
-      iter->value = macro_data->data + macro_data->name_len;
+      iter->name = (char *)names_get(macros->names, macro_data->name_id);
+      iter->value = macro_data->value;
 
-      iter->ptr += macro_data->name_len + macro_data->value_len + sizeof(struct _macro_data);
+      iter->ptr += macro_data_size(macro_data->value_len);
 
       iter->count++;
       return 0;
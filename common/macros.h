@@ -26,23 +26,27 @@
   defines_heap buffer looks like this:
   struct
   {
-    char name[];
+    uint32_t name_id;
+    int8_t param_count;
+    int16_t value_len;
     unsigned char value[];  // params are binary 0x01 to 0x09
-    int param_count;
-  };
+  };  // padded to 4 bytes
 */
 
 struct _macro_data
 {
+  uint32_t name_id;   // id of the name in the shared names pool
   int8_t param_count; // number of macro parameters
-  int8_t name_len;    // length of the macro name
   int16_t value_len;  // length of the macro
-  char data[];        // name[], value[]
+  char value[];       // value[]
 };
 
+struct _names;
+
 struct _macros
 {
   struct _memory_pool *memory_pool;
+  struct _names *names;    // pool the name ids are from
   int locked;
   char *stack[MAX_NESTED_MACROS];
   int stack_ptr;
@@ -59,11 +63,12 @@ struct _macros_iter
   int end_flag;
 };
 
-int macros_init(struct _macros *macros);
+int macros_init(struct _macros *macros, struct _names *names);
 void macros_free(struct _macros *macros);
 int macros_append(struct _asm_context *asm_context, char *name, char *value, int param_count);
 void macros_lock(struct _macros *macros);
 char *macros_lookup(struct _macros *macros, char *name, int *param_count);
+char *macros_lookup_id(struct _macros *macros, uint32_t name_id, int *param_count);
 int macros_iterate(struct _macros *macros, struct _macros_iter *iter);
 int macros_print(struct _macros *macros, FILE *out);
 int macros_push_define(struct _macros *macros, char *define);
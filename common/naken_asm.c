@@ -15,7 +15,10 @@
 #include <unistd.h>
 
 #include "common/assembler.h"
+#include "common/listing.h"
+#include "common/literals.h"
 #include "common/macros.h"
+#include "common/relax.h"
 #include "common/symbols.h"
 #include "common/tokens.h"
 #include "common/version.h"
@@ -75,15 +78,6 @@ static void new_extension(char *filename, char *ext, int len)
 
 }
 
-static void output_hex_text(FILE *fp, char *s, int ptr)
-{
-  if (ptr == 0) return;
-  s[ptr] = 0;
-  int n;
-  for (n = 0; n < ((16 - ptr) * 3) + 2; n++) { putc(' ', fp); }
-  fprintf(fp, "%s", s);
-}
-
 int main(int argc, char *argv[])
 {
   FILE *out;
@@ -286,6 +280,8 @@ int main(int argc, char *argv[])
       exit(1);
     }
 
+    setvbuf(asm_context.list, NULL, _IOFBF, LISTING_SOURCE_SIZE);
+
     if (asm_context.quiet_output == 0)
     {
       printf("  List file: %s\n", filename);
@@ -297,13 +293,19 @@ int main(int argc, char *argv[])
     printf("\nPass 1...\n");
   }
 
-  symbols_init(&asm_context.symbols);
-  macros_init(&asm_context.macros);
+  names_init(&asm_context.names);
+  symbols_init(&asm_context.symbols, &asm_context.names);
+  macros_init(&asm_context.macros, &asm_context.names);
+  listing_init(&asm_context.listing);
+  literals_init(&asm_context.literals);
+  relax_init(&asm_context.relax);
 
   asm_context.pass = 1;
   assembler_init(&asm_context);
 
   error_flag = assemble(&asm_context);
+  if (error_flag == 0) { error_flag = assembler_end_pass(&asm_context); }
+  if (error_flag == 0) { error_flag = assembler_relax(&asm_context); }
 
   if (error_flag != 0)
   {
@@ -323,6 +325,7 @@ int main(int argc, char *argv[])
     if (create_list == 1) { asm_context.write_list_file = 1; }
 
     error_flag = assemble(&asm_context);
+    if (error_flag == 0) { error_flag = assembler_end_pass(&asm_context); }
 
     if (format == FORMAT_HEX)
     {
@@ -364,46 +367,7 @@ int main(int argc, char *argv[])
 
   if (create_list == 1)
   {
-    int ch = 0;
-    char str[17];
-    int ptr = 0;
-
-    fprintf(asm_context.list, "data sections:");
-
-    for (i = asm_context.memory.low_address; i <= asm_context.memory.high_address; i++)
-    {
-      if (memory_debug_line(&asm_context, i) == -2)
-      {
-        if (ch == 0)
-        {
-          if (ptr != 0)
-          {
-            output_hex_text(asm_context.list, str, ptr);
-          }
-          fprintf(asm_context.list, "\n%04x:", i/asm_context.bytes_per_address);
-          ptr = 0;
-        }
-
-        unsigned char data = memory_read(&asm_context, i);
-        fprintf(asm_context.list, " %02x", data);
-
-        if (data >= ' ' && data <= 120)
-        { str[ptr++] = data; }
-          else
-        { str[ptr++] = '.'; }
-
-        ch++;
-        if (ch == 16) { ch = 0; }
-      }
-        else
-      {
-        output_hex_text(asm_context.list, str, ptr);
-        ch = 0;
-        ptr = 0;
-      }
-    }
-    output_hex_text(asm_context.list, str, ptr);
-    fprintf(asm_context.list, "\n\n");
+    listing_write(&asm_context);
 
     assembler_print_info(&asm_context, asm_context.list);
   }
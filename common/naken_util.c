@@ -104,6 +104,13 @@ parse_instruction_t parse_instruction_tms1000 = NULL;
 parse_instruction_t parse_instruction_tms1100 = NULL;
 parse_instruction_t parse_instruction_tms9900 = NULL;
 parse_instruction_t parse_instruction_z80 = NULL;
+parse_directive_t parse_directive_6809 = NULL;
+parse_directive_t parse_directive_65816 = NULL;
+parse_directive_t parse_directive_arm = NULL;
+parse_directive_t parse_directive_avr8 = NULL;
+parse_directive_t parse_directive_mips = NULL;
+parse_directive_t parse_directive_pic14 = NULL;
+parse_directive_t parse_directive_z80 = NULL;
 
 static char *state_stopped = "stopped";
 static char *state_running = "running";
@@ -758,7 +765,7 @@ int main(int argc, char *argv[])
 
   memset(&util_context, 0, sizeof(struct _util_context));
   memory_init(&util_context.memory, 1<<20, 1);
-  symbols_init(&util_context.symbols);
+  symbols_init(&util_context.symbols, &util_context.names);
 
 #ifndef NO_MSP430
   util_context.disasm_range = disasm_range_msp430;
@@ -1287,6 +1294,7 @@ int main(int argc, char *argv[])
   if (src != NULL) { fclose(src); }
 
   symbols_free(&util_context.symbols);
+  names_free(&util_context.names);
 
   if (util_context.debug_line_offset !=NULL)
   {
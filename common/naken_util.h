@@ -14,6 +14,7 @@
 
 #include "common/cpu_list.h"
 #include "common/memory.h"
+#include "common/names.h"
 #include "simulate/msp430.h"
 
 struct _util_context
@@ -21,6 +22,7 @@ struct _util_context
   struct _memory memory;
   struct _simulate *simulate;
   struct _symbols symbols;
+  struct _names names;
   long *debug_line_offset;
   FILE *src_fp;
   int fd;
@@ -0,0 +1,178 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "common/memory_pool.h"
+#include "common/names.h"
+
+void names_init(struct _names *names)
+{
+  memset(names, 0, sizeof(struct _names));
+}
+
+uint32_t names_hash(const char *name)
+{
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+
+  while(*name != 0)
+  {
+    hash = (hash ^ (uint8_t)*name) * 16777619u;
+    name++;
+  }
+
+  return hash;
+}
+
+static uint32_t *names_slot(struct _names *names, uint32_t hash, const char *name)
+{
+  uint32_t mask = names->table_size - 1;
+  uint32_t index = hash & mask;
+
+  while(names->table[index] != NAME_NONE)
+  {
+    struct _names_data *names_data = names->entries[names->table[index]];
+
+    if (names_data->hash == hash && strcmp(names_data->name, name) == 0)
+    {
+      break;
+    }
+
+    index = (index + 1) & mask;
+  }
+
+  return &names->table[index];
+}
+
+static void names_grow_table(struct _names *names)
+{
+  uint32_t *table = names->table;
+  int table_size = names->table_size;
+  int n;
+
+  names->table_size = table_size == 0 ? NAMES_TABLE_SIZE : table_size * 2;
+  names->table = calloc(names->table_size, sizeof(uint32_t));
+
+  for (n = 0; n < table_size; n++)
+  {
+    if (table[n] == NAME_NONE) { continue; }
+
+    struct _names_data *names_data = names->entries[table[n]];
+
+    *names_slot(names, names_data->hash, names_data->name) = table[n];
+  }
+
+  free(table);
+}
+
+uint32_t names_intern(struct _names *names, const char *name)
+{
+  struct _memory_pool *memory_pool;
+  struct _names_data *names_data;
+  uint32_t hash = names_hash(name);
+  uint32_t *slot;
+  int len, size;
+
+  // Keep the hash table at most half full.
+  if ((names->count + 1) * 2 >= names->table_size) { names_grow_table(names); }
+
+  slot = names_slot(names, hash, name);
+
+  if (*slot != NAME_NONE) { return *slot; }
+
+  len = strlen(name) + 1;
+
+  // Keep entries 4 byte aligned.
+  size = (sizeof(struct _names_data) + len + 3) & ~3;
+
+  if (size >= NAMES_HEAP_SIZE)
+  {
+    printf("Internal Error: Name '%s' is too big.\n", name);
+    return NAME_NONE;
+  }
+
+  memory_pool = names->memory_pool;
+
+  if (memory_pool == NULL)
+  {
+    memory_pool = memory_pool_add((struct _naken_heap *)names, NAMES_HEAP_SIZE);
+  }
+
+  // Find a pool that has enough area at the end to add this name.
+  // If none can be found, alloc a new one.
+  while(1)
+  {
+    if (memory_pool->ptr + size < memory_pool->len)
+    {
+      break;
+    }
+
+    if (memory_pool->next == NULL)
+    {
+      memory_pool->next = memory_pool_add((struct _naken_heap *)names, NAMES_HEAP_SIZE);
+    }
+
+    memory_pool = memory_pool->next;
+  }
+
+  // Entry 0 is NAME_NONE so ids start at 1.
+  if (names->count + 2 > names->entries_alloc)
+  {
+    names->entries_alloc += NAMES_TABLE_SIZE;
+    names->entries = realloc(names->entries,
+      names->entries_alloc * sizeof(struct _names_data *));
+  }
+
+  names_data = (struct _names_data *)(memory_pool->buffer + memory_pool->ptr);
+  names_data->hash = hash;
+  memcpy(names_data->name, name, len);
+
+  memory_pool->ptr += size;
+
+  names->count++;
+  names->entries[names->count] = names_data;
+  *slot = names->count;
+
+  return names->count;
+}
+
+uint32_t names_find(struct _names *names, const char *name)
+{
+  if (names->count == 0) { return NAME_NONE; }
+
+  return *names_slot(names, names_hash(name), name);
+}
+
+const char *names_get(struct _names *names, uint32_t id)
+{
+  if (id == NAME_NONE || id > names->count) { return NULL; }
+
+  return names->entries[id]->name;
+}
+
+int names_count(struct _names *names)
+{
+  return names->count;
+}
+
+void names_free(struct _names *names)
+{
+  memory_pool_free(names->memory_pool);
+  free(names->entries);
+  free(names->table);
+
+  memset(names, 0, sizeof(struct _names));
+}
+
@@ -0,0 +1,51 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#ifndef _NAMES_H
+#define _NAMES_H
+
+#include <stdint.h>
+
+#define NAMES_HEAP_SIZE 32768
+#define NAMES_TABLE_SIZE 1024
+#define NAME_NONE 0
+
+// Labels, macros and .equ names are stored once in a pool and referred
+// to by an id, so comparing two names is comparing two ints.  The pool is
+// owned by asm_context and shared by its symbol and macro tables (and
+// both passes) so they agree on ids.  Id 0 is never used for a real name.
+
+struct _names_data
+{
+  uint32_t hash;           // hash of name[], computed once
+  char name[];             // null terminated name
+};
+
+struct _names
+{
+  struct _memory_pool *memory_pool;
+  struct _names_data **entries;  // id -> name
+  uint32_t *table;               // hash table of ids, 0 = empty slot
+  int count;
+  int entries_alloc;
+  int table_size;
+};
+
+void names_init(struct _names *names);
+uint32_t names_hash(const char *name);
+uint32_t names_intern(struct _names *names, const char *name);
+uint32_t names_find(struct _names *names, const char *name);
+const char *names_get(struct _names *names, uint32_t id);
+int names_count(struct _names *names);
+void names_free(struct _names *names);
+
+#endif
+
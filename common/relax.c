@@ -0,0 +1,112 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "common/assembler.h"
+#include "common/relax.h"
+
+void relax_init(struct _relax *relax)
+{
+  memset(relax, 0, sizeof(struct _relax));
+}
+
+void relax_free(struct _relax *relax)
+{
+  free(relax->forms);
+  free(relax->forward);
+
+  memset(relax, 0, sizeof(struct _relax));
+}
+
+void relax_reset(struct _relax *relax)
+{
+  relax->ptr = 0;
+  relax->changed = 0;
+  relax->shortened = 0;
+  relax->saved = 0;
+  relax->delay_slots = 0;
+  relax->enabled = 0;
+}
+
+int relax_form(struct _asm_context *asm_context, int form)
+{
+  struct _relax *relax = &asm_context->relax;
+  int index = relax->ptr++;
+
+  if (index == relax->count)
+  {
+    if (relax->count == relax->alloc)
+    {
+      relax->alloc += RELAX_ALLOC_SIZE;
+      relax->forms = realloc(relax->forms, relax->alloc);
+      relax->forward = realloc(relax->forward, relax->alloc);
+    }
+
+    relax->forward[relax->count] = 0;
+    relax->forms[relax->count++] = 0;
+  }
+
+  // Pass 2 uses whatever pass 1 settled on.
+  if (asm_context->pass == 1)
+  {
+    if (form == RELAX_UNKNOWN)
+    {
+      // Only the first time through.  After that anything still unknown
+      // is an error pass 2 will report.
+      if (asm_context->symbols.redefine == 0)
+      {
+        relax->forward[index] = 1;
+        relax->changed = 1;
+      }
+    }
+      else
+    if (form > relax->forms[index])
+    {
+      relax->forms[index] = form;
+      relax->changed = 1;
+    }
+  }
+
+  return relax->forms[index];
+}
+
+int relax_forward(struct _asm_context *asm_context)
+{
+  struct _relax *relax = &asm_context->relax;
+
+  // Asks about the site relax_form() was just called for.
+  if (relax->ptr == 0) { return 0; }
+
+  return relax->forward[relax->ptr - 1];
+}
+
+void relax_shortened(struct _asm_context *asm_context)
+{
+  // Only count the final pass.
+  if (asm_context->pass == 2) { asm_context->relax.shortened++; }
+}
+
+void relax_saved(struct _asm_context *asm_context, int words)
+{
+  // Only count the final pass.
+  if (asm_context->pass == 2) { asm_context->relax.saved += words; }
+}
+
+
+void relax_delay_slot(struct _asm_context *asm_context)
+{
+  // Only count the final pass.
+  if (asm_context->pass == 2) { asm_context->relax.delay_slots++; }
+}
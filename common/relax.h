@@ -0,0 +1,53 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#ifndef _RELAX_H
+#define _RELAX_H
+
+#include <stdint.h>
+
+#define RELAX_ALLOC_SIZE 1024
+#define RELAX_MAX_PASSES 32
+#define RELAX_UNKNOWN -1
+
+struct _asm_context;
+
+// Instructions that have a short and a long form (branches that might
+// not reach, etc) are sites.  Sites are numbered in the order they are
+// seen so every pass agrees on which is which.  A site starts with its
+// shortest form (0) and can only grow, so repeating pass 1 until no site
+// grows and no label moves always finishes.
+struct _relax
+{
+  uint8_t *forms;
+  uint8_t *forward;     // the site was unknown on the first pass 1
+  int count;
+  int alloc;
+  int ptr;              // next site in this pass
+  int changed;          // a site grew or wasn't known in this pass
+  int passes;           // number of times pass 1 was repeated
+  int shortened;        // sites assembled smaller than written
+  int saved;            // instruction words saved by shortened sites
+  int delay_slots;      // delay slots filled with an earlier instruction
+  uint8_t enabled : 1;  // .relax for instructions that have to ask
+};
+
+void relax_init(struct _relax *relax);
+void relax_free(struct _relax *relax);
+void relax_reset(struct _relax *relax);
+int relax_form(struct _asm_context *asm_context, int form);
+int relax_forward(struct _asm_context *asm_context);
+void relax_shortened(struct _asm_context *asm_context);
+void relax_saved(struct _asm_context *asm_context, int words);
+void relax_delay_slot(struct _asm_context *asm_context);
+
+#endif
+
@@ -14,15 +14,27 @@
 #include <string.h>
 #include <stdint.h>
 
+#include "common/names.h"
 #include "common/symbols.h"
-#include "common/memory_pool.h"
 
-int symbols_init(struct _symbols *symbols)
+int symbols_init(struct _symbols *symbols, struct _names *names)
 {
-  symbols->memory_pool = NULL;
+  symbols->names = names;
+  symbols->hash = NULL;
+  symbols->name_id = NULL;
+  symbols->scope = NULL;
+  symbols->address = NULL;
+  symbols->flags = NULL;
+  symbols->next = NULL;
+  symbols->buckets = NULL;
+  symbols->count = 0;
+  symbols->alloc = 0;
+  symbols->bucket_count = 0;
   symbols->locked = 0;
   symbols->in_scope = 0;
   symbols->debug = 0;
+  symbols->redefine = 0;
+  symbols->moved = 0;
   symbols->current_scope = 0;
 
   return 0;
@@ -30,71 +42,115 @@ int symbols_init(struct _symbols *symbols)
 
 void symbols_free(struct _symbols *symbols)
 {
-  memory_pool_free(symbols->memory_pool);
-  symbols->memory_pool = NULL;
+  free(symbols->hash);
+  free(symbols->name_id);
+  free(symbols->scope);
+  free(symbols->address);
+  free(symbols->flags);
+  free(symbols->next);
+  free(symbols->buckets);
+
+  symbols->hash = NULL;
+  symbols->name_id = NULL;
+  symbols->scope = NULL;
+  symbols->address = NULL;
+  symbols->flags = NULL;
+  symbols->next = NULL;
+  symbols->buckets = NULL;
+  symbols->count = 0;
+  symbols->alloc = 0;
+  symbols->bucket_count = 0;
 }
 
-struct _symbols_data *symbols_find(struct _symbols *symbols, char *name)
+static uint32_t symbols_hash(uint32_t name_id, uint32_t scope)
 {
-  struct _memory_pool *memory_pool = symbols->memory_pool;
-  int ptr;
+  uint32_t hash = (name_id * 0x9e3779b1) ^ (scope * 0x85ebca6b);
 
-  // Check local scope.
-  if (symbols->in_scope != 0)
+  return hash ^ (hash >> 16);
+}
+
+static int symbols_find_scope(struct _symbols *symbols, uint32_t name_id, uint32_t scope)
+{
+  uint32_t hash;
+  int n;
+
+  if (symbols->count == 0) { return -1; }
+
+  hash = symbols_hash(name_id, scope);
+
+  n = symbols->buckets[hash & (symbols->bucket_count - 1)];
+
+  while(n != -1)
   {
-    while(memory_pool != NULL)
+    if (symbols->hash[n] == hash &&
+        symbols->name_id[n] == name_id &&
+        symbols->scope[n] == scope)
     {
-      ptr = 0;
+      return n;
+    }
 
-      while(ptr < memory_pool->ptr)
-      {
-        struct _symbols_data *symbols_data =
-          (struct _symbols_data *)(memory_pool->buffer + ptr);
+    n = symbols->next[n];
+  }
 
-        if (symbols->current_scope == symbols_data->scope &&
-            strcmp(symbols_data->name, name) == 0)
-        {
-          return symbols_data;
-        }
+  return -1;
+}
 
-        ptr += symbols_data->len + sizeof(struct _symbols_data);
-      }
+int symbols_find(struct _symbols *symbols, char *name)
+{
+  uint32_t name_id = names_find(symbols->names, name);
 
-      memory_pool = memory_pool->next;
-    }
+  if (name_id == NAME_NONE) { return -1; }
 
-    memory_pool = symbols->memory_pool;
+  return symbols_find_id(symbols, name_id);
+}
+
+int symbols_find_id(struct _symbols *symbols, uint32_t name_id)
+{
+  // Check local scope.
+  if (symbols->in_scope != 0)
+  {
+    int index = symbols_find_scope(symbols, name_id, symbols->current_scope);
+
+    if (index != -1) { return index; }
   }
 
   // Check global scope.
-  while(memory_pool != NULL)
-  {
-    ptr = 0;
+  return symbols_find_scope(symbols, name_id, 0);
+}
 
-    while(ptr < memory_pool->ptr)
-    {
-      struct _symbols_data *symbols_data =
-        (struct _symbols_data *)(memory_pool->buffer + ptr);
+static void symbols_grow(struct _symbols *symbols)
+{
+  int n, mask;
 
-      if (symbols_data->scope == 0 && strcmp(symbols_data->name, name) == 0)
-      {
-        return symbols_data;
-      }
+  symbols->alloc += symbols->alloc == 0 ? SYMBOLS_ALLOC_SIZE : symbols->alloc;
 
-      ptr += symbols_data->len + sizeof(struct _symbols_data);
-    }
+  symbols->hash = realloc(symbols->hash, symbols->alloc * sizeof(uint32_t));
+  symbols->name_id = realloc(symbols->name_id, symbols->alloc * sizeof(uint32_t));
+  symbols->scope = realloc(symbols->scope, symbols->alloc * sizeof(uint32_t));
+  symbols->address = realloc(symbols->address, symbols->alloc * sizeof(uint32_t));
+  symbols->flags = realloc(symbols->flags, symbols->alloc * sizeof(uint8_t));
+  symbols->next = realloc(symbols->next, symbols->alloc * sizeof(int));
 
-    memory_pool = memory_pool->next;
-  }
+  // Keep one bucket per possible symbol and rebuild the chains.
+  symbols->bucket_count = symbols->alloc;
+  symbols->buckets = realloc(symbols->buckets, symbols->bucket_count * sizeof(int));
+
+  mask = symbols->bucket_count - 1;
+
+  for (n = 0; n < symbols->bucket_count; n++) { symbols->buckets[n] = -1; }
 
-  return NULL;
+  for (n = 0; n < symbols->count; n++)
+  {
+    symbols->next[n] = symbols->buckets[symbols->hash[n] & mask];
+    symbols->buckets[symbols->hash[n] & mask] = n;
+  }
 }
 
 int symbols_append(struct _symbols *symbols, char *name, uint32_t address)
 {
-  int token_len;
-  struct _memory_pool *memory_pool = symbols->memory_pool;
-  struct _symbols_data *symbols_data;
+  uint32_t name_id;
+  uint32_t hash;
+  int index;
 
 #ifdef DEBUG
 //printf("symbols_append(%s, %d);\n", name, address);
@@ -102,96 +158,96 @@ int symbols_append(struct _symbols *symbols, char *name, uint32_t address)
 
   if (symbols->locked == 1) { return 0; }
 
-  symbols_data = symbols_find(symbols, name);
+  name_id = names_intern(symbols->names, name);
+
+  if (name_id == NAME_NONE) { return -1; }
+
+  // When pass 1 is repeated every label is seen again and only its
+  // address can change.
+  if (symbols->redefine == 1)
+  {
+    index = symbols_find_scope(symbols, name_id,
+      symbols->in_scope == 0 ? 0 : symbols->current_scope);
+
+    if (index != -1)
+    {
+      if (symbols->address[index] != address)
+      {
+        symbols->address[index] = address;
+        symbols->moved++;
+      }
+
+      return 0;
+    }
+  }
+
+  index = symbols_find_id(symbols, name_id);
 
-  if (symbols_data != NULL)
+  if (index != -1)
   {
     // For unit test.  Probably a better way to do this.
     if (symbols->debug == 1)
     {
-      symbols_data->address = address;
+      symbols->address[index] = address;
       return 0;
     }
 
-    if (symbols->in_scope == 0 || symbols_data->scope == symbols->current_scope)
+    if (symbols->in_scope == 0 || symbols->scope[index] == symbols->current_scope)
     {
       printf("Error: Label '%s' already defined.\n", name);
       return -1;
     }
   }
 
-  token_len = strlen(name) + 1;
-
-  // Check if size of new label is bigger than 255.
-  if (token_len > 255)
-  {
-    printf("Error: Label '%s' is too big.\n", name);
-    return -1;
-  }
-
-  // If we have no pool, add one.
-  if (memory_pool == NULL)
-  {
-    memory_pool = memory_pool_add((struct _naken_heap *)symbols, SYMBOLS_HEAP_SIZE);
-  }
-
-  // Find a pool that has enough area at the end to add this address.
-  // If none can be found, alloc a new one.
-  while(1)
-  {
-     if (memory_pool->ptr + token_len + sizeof(struct _symbols_data) < memory_pool->len)
-     {
-       break;
-     }
-
-     if (memory_pool->next == NULL)
-     {
-       memory_pool->next = memory_pool_add((struct _naken_heap *)symbols, SYMBOLS_HEAP_SIZE);
-     }
-
-     memory_pool = memory_pool->next;
-  }
+  if (symbols->count == symbols->alloc) { symbols_grow(symbols); }
 
   // Divide by bytes_per_address (for AVR8 and dsPIC).
   //address = address / asm_context->bytes_per_address;
 
   // Set the new label/address entry.
-  symbols_data =
-    (struct _symbols_data *)(memory_pool->buffer + memory_pool->ptr);
+  index = symbols->count++;
 
-  memcpy(symbols_data->name, name, token_len);
-  symbols_data->len = token_len;
-  symbols_data->flag_rw = 0;
-  symbols_data->flag_export = 0;
-  symbols_data->address = address;
-  symbols_data->scope = symbols->in_scope == 0 ? 0 : symbols->current_scope;
+  symbols->name_id[index] = name_id;
+  symbols->scope[index] = symbols->in_scope == 0 ? 0 : symbols->current_scope;
+  symbols->address[index] = address;
+  symbols->flags[index] = 0;
 
-  memory_pool->ptr += token_len + sizeof(struct _symbols_data);
+  hash = symbols_hash(name_id, symbols->scope[index]);
+
+  symbols->hash[index] = hash;
+  symbols->next[index] = symbols->buckets[hash & (symbols->bucket_count - 1)];
+  symbols->buckets[hash & (symbols->bucket_count - 1)] = index;
 
   return 0;
-} 
+}
 
 int symbols_set(struct _symbols *symbols, char *name, uint32_t address)
 {
-  struct _symbols_data *symbols_data = NULL;
+  int index;
 
-  symbols_data = symbols_find(symbols, name);
+  index = symbols_find(symbols, name);
 
-  if (symbols_data == NULL)
+  if (index == -1)
   {
-    if (symbols_append(symbols, name, address) != 0)
-    {
-      return -1; 
-    }
+    uint8_t in_scope = symbols->in_scope;
+    int ret;
+
+    // Variables created by .set are always global.
+    symbols->in_scope = 0;
+    ret = symbols_append(symbols, name, address);
+    symbols->in_scope = in_scope;
+
+    if (ret != 0) { return -1; }
 
-    symbols_data = symbols_find(symbols, name);
-    symbols_data->scope = 0;
-    symbols_data->flag_rw = 1;
+    index = symbols_find(symbols, name);
+    if (index == -1) { return -1; }
+
+    symbols->flags[index] |= SYMBOL_FLAG_RW;
   }
     else
-  if (symbols_data->flag_rw == 1)
+  if ((symbols->flags[index] & SYMBOL_FLAG_RW) != 0)
   {
-    symbols_data->address = address;
+    symbols->address[index] = address;
   }
     else
   {
@@ -203,17 +259,17 @@ int symbols_set(struct _symbols *symbols, char *name, uint32_t address)
 
 int symbols_export(struct _symbols *symbols, char *name)
 {
-  struct _symbols_data *symbols_data = symbols_find(symbols, name);
+  int index = symbols_find(symbols, name);
 
-  if (symbols_data == NULL) { return -1; }
+  if (index == -1) { return -1; }
 
-  if (symbols_data->scope != 0)
+  if (symbols->scope[index] != 0)
   {
     printf("Error: Cannot export local variable '%s'\n", name);
     return -1;
   }
 
-  symbols_data->flag_export = 1;
+  symbols->flags[index] |= SYMBOL_FLAG_EXPORT;
 
   return 0;
 }
@@ -225,53 +281,39 @@ void symbols_lock(struct _symbols *symbols)
 
 int symbols_lookup(struct _symbols *symbols, char *name, uint32_t *address)
 {
-  struct _symbols_data *symbols_data = symbols_find(symbols, name);
+  int index = symbols_find(symbols, name);
 
-  if (symbols_data == NULL)
+  if (index == -1)
   {
     *address = 0;
     return -1;
   }
 
-  *address = symbols_data->address;
+  *address = symbols->address[index];
 
   return 0;
 }
 
 int symbols_iterate(struct _symbols *symbols, struct _symbols_iter *iter)
 {
-  struct _memory_pool *memory_pool = symbols->memory_pool;
+  int index = iter->ptr;
 
   if (iter->end_flag == 1) { return -1; }
-  if (iter->memory_pool == NULL)
-  {
-    iter->memory_pool = symbols->memory_pool;
-    iter->ptr = 0;
-  }
 
-  while(memory_pool != NULL)
+  if (index >= symbols->count)
   {
-    if(iter->ptr < memory_pool->ptr)
-    {
-      struct _symbols_data * symbols_data =
-        (struct _symbols_data *)(memory_pool->buffer + iter->ptr);
-
-      iter->address = symbols_data->address;
-      iter->name = symbols_data->name;
-      iter->ptr = iter->ptr + symbols_data->len + sizeof(struct _symbols_data);
-      iter->flag_export = symbols_data->flag_export;
-      iter->scope = symbols_data->scope;
-      iter->count++;
-
-      return 0;
-    }
-
-    memory_pool = memory_pool->next;
+    iter->end_flag = 1;
+    return -1;
   }
 
-  iter->end_flag = 1;
+  iter->address = symbols->address[index];
+  iter->name = (char *)names_get(symbols->names, symbols->name_id[index]);
+  iter->flag_export = (symbols->flags[index] & SYMBOL_FLAG_EXPORT) != 0;
+  iter->scope = symbols->scope[index];
+  iter->ptr = index + 1;
+  iter->count++;
 
-  return -1;
+  return 0;
 }
 
 int symbols_print(struct _symbols *symbols, FILE *out)
@@ -294,45 +336,17 @@ int symbols_print(struct _symbols *symbols, FILE *out)
 
 int symbols_count(struct _symbols *symbols)
 {
-  struct _memory_pool *memory_pool = symbols->memory_pool;
-  int ptr;
-  int count = 0;
-
-  while(memory_pool != NULL)
-  {
-    ptr = 0;
-    while(ptr < memory_pool->ptr)
-    {
-      struct _symbols_data *symbols_data =
-        (struct _symbols_data *)(memory_pool->buffer + ptr);
-      ptr += symbols_data->len + sizeof(struct _symbols_data);
-      count++;
-    }
-
-    memory_pool = memory_pool->next;
-  }
-
-  return count;
+  return symbols->count;
 }
 
 int symbols_export_count(struct _symbols *symbols)
 {
-  struct _memory_pool *memory_pool = symbols->memory_pool;
-  int ptr;
   int count = 0;
+  int n;
 
-  while(memory_pool != NULL)
+  for (n = 0; n < symbols->count; n++)
   {
-    ptr = 0;
-    while(ptr < memory_pool->ptr)
-    {
-      struct _symbols_data *symbols_data =
-        (struct _symbols_data *)(memory_pool->buffer + ptr);
-      ptr += symbols_data->len + sizeof(struct _symbols_data);
-      if (symbols_data->flag_export == 1) { count++; }
-    }
-
-    memory_pool = memory_pool->next;
+    if ((symbols->flags[n] & SYMBOL_FLAG_EXPORT) != 0) { count++; }
   }
 
   return count;
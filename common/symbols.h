@@ -14,30 +14,40 @@
 
 #include <stdint.h>
 
-#define SYMBOLS_HEAP_SIZE 32768
+#define SYMBOLS_ALLOC_SIZE 1024
 
-struct _symbols_data
-{
-  uint8_t len;             // length of name[]
-  uint8_t flag_rw : 1;     // can write to this
-  uint8_t flag_export : 1; // ELF will export symbol
-  uint16_t scope;          // Up to 65535 local scopes.  0 = global.
-  uint32_t address;        // address for this name
-  char name[];             // null terminated name of label:
-};
+#define SYMBOL_FLAG_RW 1        // can write to this
+#define SYMBOL_FLAG_EXPORT 2    // ELF will export symbol
+
+// Each symbol is an index into these arrays, so scans that only need one
+// field (address, flags) walk one array.  Lookups go through a hash
+// table keyed on (name id, scope) so a name reused in many scopes is
+// still found with one probe.
+struct _names;
 
 struct _symbols
 {
-  struct _memory_pool *memory_pool;
+  struct _names *names;    // pool the name ids are from
+  uint32_t *hash;          // hash of name_id and scope
+  uint32_t *name_id;       // id of the name in the shared names pool
+  uint32_t *scope;         // local scope of the symbol.  0 = global.
+  uint32_t *address;       // address for this name
+  uint8_t *flags;          // SYMBOL_FLAG_*
+  int *next;               // next symbol in the same bucket or -1
+  int *buckets;            // hash table of symbol indexes, -1 = empty
+  int count;
+  int alloc;
+  int bucket_count;
   uint8_t locked : 1;
   uint8_t in_scope : 1;
   uint8_t debug : 1;
+  uint8_t redefine : 1;    // pass 1 is being repeated (relaxation)
+  int moved;               // labels that moved while redefine is set
   uint32_t current_scope;
 };
 
 struct _symbols_iter
 {
-  struct _memory_pool *memory_pool;
   char *name;
   uint32_t address;
   int ptr;
@@ -47,9 +57,10 @@ struct _symbols_iter
   uint8_t flag_export : 1;
 };
 
-int symbols_init(struct _symbols *symbols);
+int symbols_init(struct _symbols *symbols, struct _names *names);
 void symbols_free(struct _symbols *symbols);
-struct _symbols_data *symbols_find(struct _symbols *symbols, char *name);
+int symbols_find(struct _symbols *symbols, char *name);
+int symbols_find_id(struct _symbols *symbols, uint32_t name_id);
 int symbols_append(struct _symbols *symbols, char *name, uint32_t address);
 int symbols_set(struct _symbols *symbols, char *name, uint32_t address);
 int symbols_export(struct _symbols *symbols, char *name);
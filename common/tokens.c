@@ -19,6 +19,7 @@
 
 #include "common/assembler.h"
 #include "common/macros.h"
+#include "common/names.h"
 #include "common/symbols.h"
 #include "common/tokens.h"
 
@@ -193,7 +194,7 @@ int tokens_get_char(struct _asm_context *asm_context)
 
     if (asm_context->list != NULL && asm_context->write_list_file == 1)
     {
-      if (ch != EOF) { putc(ch, asm_context->list); }
+      if (ch != EOF) { listing_source_char(&asm_context->listing, ch); }
     }
   }
     else
@@ -566,17 +567,27 @@ int tokens_get(struct _asm_context *asm_context, char *token, int len)
   if (token_type == TOKEN_STRING)
   {
     int param_count = 0;
-    char *macro = macros_lookup(&asm_context->macros, token, &param_count);
-    uint32_t address;
+    uint32_t name_id = names_find(&asm_context->names, token);
+    char *macro = NULL;
+    uint32_t address = 0;
     int ret = -1;
 
-    if (asm_context->no_symbols == 0)
+    // Most strings (mnemonics, registers) were never interned so there
+    // is nothing to look up.
+    if (name_id != NAME_NONE)
     {
-      ret = symbols_lookup(&asm_context->symbols, token, &address);
-    }
-      else
-    {
-      ret = -1;
+      macro = macros_lookup_id(&asm_context->macros, name_id, &param_count);
+
+      if (asm_context->no_symbols == 0)
+      {
+        int index = symbols_find_id(&asm_context->symbols, name_id);
+
+        if (index != -1)
+        {
+          address = asm_context->symbols.address[index];
+          ret = 0;
+        }
+      }
     }
 
     if (ret == 0 && asm_context->parsing_ifdef == 0)
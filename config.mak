@@ -0,0 +1,145 @@
+# Generated include file
+# ./configure 
+
+CC=gcc
+COMPILER_PREFIX=
+LDFLAGS= -s
+LDFLAGS_UTIL= -lreadline
+CFLAGS=-Wall -DREADLINE -O3
+DFLAGS=-DENABLE_4004 -DENABLE_6502 -DENABLE_6800 -DENABLE_6809 -DENABLE_65816 -DENABLE_68HC08 -DENABLE_68000 -DENABLE_8051 -DENABLE_ARC -DENABLE_ARM -DENABLE_AVR8 -DENABLE_CELL -DENABLE_DSPIC -DENABLE_EMOTION_ENGINE -DENABLE_EPIPHANY -DENABLE_LC3 -DENABLE_MIPS -DENABLE_MSP430 -DENABLE_PIC14 -DENABLE_POWERPC -DENABLE_PROPELLER -DENABLE_RISCV -DENABLE_STM8 -DENABLE_SUPER_FX -DENABLE_THUMB -DENABLE_TMS1000 -DENABLE_TMS9900 -DENABLE_Z80
+INSTALL_BIN=/usr/local/bin
+INSTALL_INCLUDES=/usr/local/share/naken_asm
+INCLUDE_PATH=/usr/local/share/naken_asm/include
+CONFIG_EXT=
+ASM_OBJS= \
+  asm/4004.o \
+  asm/6502.o \
+  asm/65816.o \
+  asm/6800.o \
+  asm/68000.o \
+  asm/6809.o \
+  asm/68hc08.o \
+  asm/8051.o \
+  asm/arc.o \
+  asm/arm.o \
+  asm/avr8.o \
+  asm/cell.o \
+  asm/common.o \
+  asm/dspic.o \
+  asm/epiphany.o \
+  asm/lc3.o \
+  asm/mips.o \
+  asm/msp430.o \
+  asm/pic14.o \
+  asm/powerpc.o \
+  asm/propeller.o \
+  asm/ps2_ee_vu.o \
+  asm/riscv.o \
+  asm/stm8.o \
+  asm/super_fx.o \
+  asm/thumb.o \
+  asm/tms1000.o \
+  asm/tms9900.o \
+  asm/z80.o
+DISASM_OBJS= \
+  disasm/4004.o \
+  disasm/6502.o \
+  disasm/65816.o \
+  disasm/6800.o \
+  disasm/68000.o \
+  disasm/6809.o \
+  disasm/68hc08.o \
+  disasm/8051.o \
+  disasm/arc.o \
+  disasm/arm.o \
+  disasm/avr8.o \
+  disasm/cell.o \
+  disasm/dspic.o \
+  disasm/epiphany.o \
+  disasm/lc3.o \
+  disasm/mips.o \
+  disasm/msp430.o \
+  disasm/pic14.o \
+  disasm/powerpc.o \
+  disasm/propeller.o \
+  disasm/ps2_ee_vu.o \
+  disasm/riscv.o \
+  disasm/stm8.o \
+  disasm/super_fx.o \
+  disasm/thumb.o \
+  disasm/tms1000.o \
+  disasm/tms9900.o \
+  disasm/z80.o
+TABLE_OBJS= \
+  table/4004.o \
+  table/6502.o \
+  table/65816.o \
+  table/6800.o \
+  table/68000.o \
+  table/6809.o \
+  table/68hc08.o \
+  table/8051.o \
+  table/arc.o \
+  table/arm.o \
+  table/avr8.o \
+  table/cell.o \
+  table/dspic.o \
+  table/epiphany.o \
+  table/lc3.o \
+  table/mips.o \
+  table/msp430.o \
+  table/pic14.o \
+  table/powerpc.o \
+  table/propeller.o \
+  table/ps2_ee_vu.o \
+  table/riscv.o \
+  table/stm8.o \
+  table/super_fx.o \
+  table/thumb.o \
+  table/tms1000.o \
+  table/tms9900.o \
+  table/z80.o
+COMMON_OBJS= \
+  common/assembler.o \
+  common/cpu_list.o \
+  common/directives_data.o \
+  common/directives_if.o \
+  common/directives_include.o \
+  common/eval_expression.o \
+  common/eval_expression_ex.o \
+  common/print_error.o \
+  common/relax.o \
+  common/tokens.o \
+  common/ifdef_expression.o \
+  common/listing.o \
+  common/literals.o \
+  common/macros.o \
+  common/memory.o \
+  common/memory_pool.o \
+  common/names.o \
+  common/symbols.o \
+  common/var.o
+SIM_OBJS= \
+  simulate/6502.o \
+  simulate/65816.o \
+  simulate/avr8.o \
+  simulate/lc3.o \
+  simulate/mips.o \
+  simulate/msp430.o \
+  simulate/null.o \
+  simulate/tms9900.o \
+  simulate/z80.o
+FILEIO_OBJS= \
+  fileio/read_bin.o \
+  fileio/read_elf.o \
+  fileio/read_hex.o \
+  fileio/read_srec.o \
+  fileio/read_ti_txt.o \
+  fileio/write_bin.o \
+  fileio/write_elf.o \
+  fileio/write_hex.o \
+  fileio/write_srec.o
+PROG_OBJS= \
+  prog/lpc.o \
+  prog/serial.o
+
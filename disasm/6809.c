@@ -378,6 +378,14 @@ int disasm_6809(struct _memory *memory, uint32_t address, char *instruction, int
               sprintf(instruction, "%s 0x%04x (%d)", table_6809[n].instr, (address + 2 + offset) & 0xffff, offset);
               return 2;
             }
+              else
+            if (table_6809[n].bytes == 3)
+            {
+              int16_t offset = READ_RAM16(address + 1);
+
+              sprintf(instruction, "%s 0x%04x (%d)", table_6809[n].instr, (address + 3 + offset) & 0xffff, offset);
+              return 3;
+            }
 
             break;
           }
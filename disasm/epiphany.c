@@ -206,7 +206,7 @@ int disasm_epiphany(struct _memory *memory, uint32_t address, char *instr, int *
           sprintf(instr, "%s r%d", table_epiphany[n].instr, rn);
           return 4;
         case OP_NUM6_16:
-          imm = opcode32 >> 10;
+          imm = opcode16 >> 10;
           sprintf(instr, "%s %d", table_epiphany[n].instr, imm);
           return 2;
         case OP_NONE_16:
@@ -891,8 +891,8 @@ static void list_output_msp430_both(struct _asm_context *asm_context, uint32_t s
       count -= 2;
     }
 
-    // FIXME - start should be added to by count
-    break;
+    // A relaxed jump is more than one instruction.
+    start += 2;
   }
 }
 
@@ -47,6 +47,131 @@ int get_cycle_count_riscv(unsigned short int opcode)
   return -1;
 }
 
+static int disasm_riscv_comp(uint32_t address, uint32_t opcode, char *instruction)
+{
+  int32_t imm;
+  int n;
+
+  n = 0;
+  while(table_riscv_comp[n].instr != NULL)
+  {
+    if ((opcode & table_riscv_comp[n].mask) == table_riscv_comp[n].opcode)
+    {
+      uint32_t rd = (opcode >> 7) & 0x1f;
+      uint32_t rs2 = (opcode >> 2) & 0x1f;
+      uint32_t rd_c = ((opcode >> 2) & 0x7) + 8;
+      uint32_t rs1_c = ((opcode >> 7) & 0x7) + 8;
+      const char *instr = table_riscv_comp[n].instr;
+
+      switch(table_riscv_comp[n].type)
+      {
+        case OP_C_NONE:
+          sprintf(instruction, "%s", instr);
+          break;
+        case OP_C_ADDI4SPN:
+          imm = ((opcode >> 11) & 0x3) << 4;
+          imm |= ((opcode >> 7) & 0xf) << 6;
+          imm |= ((opcode >> 6) & 0x1) << 2;
+          imm |= ((opcode >> 5) & 0x1) << 3;
+          sprintf(instruction, "%s x%d, x2, %d", instr, rd_c, imm);
+          break;
+        case OP_C_LOAD:
+        case OP_C_STORE:
+          imm = ((opcode >> 10) & 0x7) << 3;
+          imm |= ((opcode >> 6) & 0x1) << 2;
+          imm |= ((opcode >> 5) & 0x1) << 6;
+          sprintf(instruction, "%s x%d, %d(x%d)", instr, rd_c, imm, rs1_c);
+          break;
+        case OP_C_RD_IMM:
+        case OP_C_LUI:
+          imm = ((opcode >> 2) & 0x1f);
+          if ((opcode & 0x1000) != 0) { imm |= 0xffffffe0; }
+          if (table_riscv_comp[n].type == OP_C_LUI)
+          {
+            sprintf(instruction, "%s x%d, 0x%x", instr, rd, imm & 0xfffff);
+          }
+            else
+          {
+            sprintf(instruction, "%s x%d, %d", instr, rd, imm);
+          }
+          break;
+        case OP_C_ANDI:
+          imm = ((opcode >> 2) & 0x1f);
+          if ((opcode & 0x1000) != 0) { imm |= 0xffffffe0; }
+          sprintf(instruction, "%s x%d, %d", instr, rs1_c, imm);
+          break;
+        case OP_C_JUMP:
+          imm = ((opcode >> 12) & 0x1) << 11;
+          imm |= ((opcode >> 11) & 0x1) << 4;
+          imm |= ((opcode >> 9) & 0x3) << 8;
+          imm |= ((opcode >> 8) & 0x1) << 10;
+          imm |= ((opcode >> 7) & 0x1) << 6;
+          imm |= ((opcode >> 6) & 0x1) << 7;
+          imm |= ((opcode >> 3) & 0x7) << 1;
+          imm |= ((opcode >> 2) & 0x1) << 5;
+          if ((imm & 0x800) != 0) { imm |= 0xfffff000; }
+          sprintf(instruction, "%s 0x%x (%d)", instr, address + imm, imm);
+          break;
+        case OP_C_ADDI16SP:
+          imm = ((opcode >> 12) & 0x1) << 9;
+          imm |= ((opcode >> 6) & 0x1) << 4;
+          imm |= ((opcode >> 5) & 0x1) << 6;
+          imm |= ((opcode >> 3) & 0x3) << 7;
+          imm |= ((opcode >> 2) & 0x1) << 5;
+          if ((imm & 0x200) != 0) { imm |= 0xfffffc00; }
+          sprintf(instruction, "%s x2, %d", instr, imm);
+          break;
+        case OP_C_SHIFT:
+          sprintf(instruction, "%s x%d, %d", instr, rs1_c, rs2);
+          break;
+        case OP_C_ALU:
+          sprintf(instruction, "%s x%d, x%d", instr, rs1_c, rd_c);
+          break;
+        case OP_C_BRANCH:
+          imm = ((opcode >> 12) & 0x1) << 8;
+          imm |= ((opcode >> 10) & 0x3) << 3;
+          imm |= ((opcode >> 5) & 0x3) << 6;
+          imm |= ((opcode >> 3) & 0x3) << 1;
+          imm |= ((opcode >> 2) & 0x1) << 5;
+          if ((imm & 0x100) != 0) { imm |= 0xfffffe00; }
+          sprintf(instruction, "%s x%d, 0x%x (%d)", instr, rs1_c, address + imm, imm);
+          break;
+        case OP_C_SLLI:
+          sprintf(instruction, "%s x%d, %d", instr, rd, rs2);
+          break;
+        case OP_C_LWSP:
+          imm = ((opcode >> 12) & 0x1) << 5;
+          imm |= ((opcode >> 4) & 0x7) << 2;
+          imm |= ((opcode >> 2) & 0x3) << 6;
+          sprintf(instruction, "%s x%d, %d(x2)", instr, rd, imm);
+          break;
+        case OP_C_SWSP:
+          imm = ((opcode >> 9) & 0xf) << 2;
+          imm |= ((opcode >> 7) & 0x3) << 6;
+          sprintf(instruction, "%s x%d, %d(x2)", instr, rs2, imm);
+          break;
+        case OP_C_JR:
+          sprintf(instruction, "%s x%d", instr, rd);
+          break;
+        case OP_C_MV:
+          sprintf(instruction, "%s x%d, x%d", instr, rd, rs2);
+          break;
+        default:
+          strcpy(instruction, "???");
+          break;
+      }
+
+      return 2;
+    }
+
+    n++;
+  }
+
+  strcpy(instruction, "???");
+
+  return 2;
+}
+
 int disasm_riscv(struct _memory *memory, uint32_t address, char *instruction, int *cycles_min, int *cycles_max)
 {
   uint32_t opcode;
@@ -61,6 +186,12 @@ int disasm_riscv(struct _memory *memory, uint32_t address, char *instruction, in
 
   opcode = READ_RAM(address);
 
+  // The low 2 bits of a 32 bit instruction are always 11.
+  if ((opcode & 0x3) != 0x3)
+  {
+    return disasm_riscv_comp(address, opcode & 0xffff, instruction);
+  }
+
   n = 0;
   while(table_riscv[n].instr != NULL)
   {
@@ -97,7 +228,7 @@ int disasm_riscv(struct _memory *memory, uint32_t address, char *instruction, in
           immediate |= ((opcode >> 7) & 0x1) << 11;
           immediate |= ((opcode >> 25) & 0x3f) << 5;
           if ((immediate & 0x1000) != 0) { immediate |= 0xffffe000; }
-          sprintf(instruction, "%s x%d, x%d, 0x%x (%d)", instr, rs1, rs2, address + 4 + immediate, immediate);
+          sprintf(instruction, "%s x%d, x%d, 0x%x (%d)", instr, rs1, rs2, address + immediate, immediate);
           break;
         case OP_U_TYPE:
           immediate = opcode >> 12;
@@ -109,7 +240,7 @@ int disasm_riscv(struct _memory *memory, uint32_t address, char *instruction, in
           immediate |= ((opcode >> 20) & 0x1) << 11;
           immediate |= ((opcode >> 21) & 0x3ff) << 1;
           if ((immediate & 0x100000) != 0) { immediate |= 0xfff00000; }
-          sprintf(instruction, "%s x%d, 0x%x", instr, rd, immediate);
+          sprintf(instruction, "%s x%d, 0x%x (%d)", instr, rd, address + immediate, immediate);
           break;
         case OP_SHIFT:
           immediate = (opcode >> 20) & 0x1f;
@@ -224,6 +355,7 @@ void list_output_riscv(struct _asm_context *asm_context, uint32_t start, uint32_
   int cycles_min,cycles_max;
   char instruction[128];
   uint32_t opcode;
+  int count;
 
   fprintf(asm_context->list, "\n");
 
@@ -231,9 +363,16 @@ void list_output_riscv(struct _asm_context *asm_context, uint32_t start, uint32_
   {
     opcode = memory_read32_m(&asm_context->memory, start);
 
-    disasm_riscv(&asm_context->memory, start, instruction, &cycles_min, &cycles_max);
+    count = disasm_riscv(&asm_context->memory, start, instruction, &cycles_min, &cycles_max);
 
-    fprintf(asm_context->list, "0x%08x: 0x%08x %-40s cycles: ", start, opcode, instruction);
+    if (count == 2)
+    {
+      fprintf(asm_context->list, "0x%08x: 0x%04x     %-40s cycles: ", start, opcode & 0xffff, instruction);
+    }
+      else
+    {
+      fprintf(asm_context->list, "0x%08x: 0x%08x %-40s cycles: ", start, opcode, instruction);
+    }
 
     if (cycles_min == -1)
     { fprintf(asm_context->list, "\n"); }
@@ -243,7 +382,7 @@ void list_output_riscv(struct _asm_context *asm_context, uint32_t start, uint32_
       else
     { fprintf(asm_context->list, "%d-%d\n", cycles_min, cycles_max); }
 
-    start += 4;
+    start += count == 2 ? 2 : 4;
   }
 }
 
@@ -265,7 +404,14 @@ void disasm_range_riscv(struct _memory *memory, uint32_t flags, uint32_t start,
 
     count = disasm_riscv(memory, start, instruction, &cycles_min, &cycles_max);
 
-    printf("0x%08x: 0x%08x %-40s cycles: ", start, opcode, instruction);
+    if (count == 2)
+    {
+      printf("0x%08x: 0x%04x     %-40s cycles: ", start, opcode & 0xffff, instruction);
+    }
+      else
+    {
+      printf("0x%08x: 0x%08x %-40s cycles: ", start, opcode, instruction);
+    }
 
     if (cycles_min == -1)
     { printf("\n"); }
@@ -14,6 +14,7 @@
 #include <string.h>
 
 #include "common/assembler.h"
+#include "common/names.h"
 #include "common/symbols.h"
 #include "fileio/write_elf.h"
 
@@ -425,8 +426,9 @@ int write_elf(struct _memory *memory, FILE *out, struct _symbols *symbols, const
   const int strtab_extras = 2;
 
   {
-    struct _symbols_iter iter;
+    const char *name;
     int sym_offset;
+    int index;
     int n;
 
     symbol_count = symbols_export_count(symbols);
@@ -442,14 +444,15 @@ int write_elf(struct _memory *memory, FILE *out, struct _symbols *symbols, const
     sym_offset = strlen(filename) + 2;
 
     n = 0;
-    memset(&iter, 0, sizeof(iter));
-    while(symbols_iterate(symbols, &iter) != -1)
+    for (index = 0; index < symbols->count; index++)
     {
-      if (iter.flag_export == 0) { continue; }
+      if ((symbols->flags[index] & SYMBOL_FLAG_EXPORT) == 0) { continue; }
+
+      name = names_get(symbols->names, symbols->name_id[index]);
 
       symbol_address[n++] = sym_offset;
-      fprintf(out, "%s%c", iter.name, 0);
-      sym_offset += strlen((char *)iter.name) + 1;
+      fprintf(out, "%s%c", name, 0);
+      sym_offset += strlen(name) + 1;
     }
 
     elf.sections_size.strtab = ftell(out) - elf.sections_offset.strtab;
@@ -487,14 +490,13 @@ int write_elf(struct _memory *memory, FILE *out, struct _symbols *symbols, const
 
     // symbols from lookup tables
     n = 0;
-    memset(&iter, 0, sizeof(iter));
-    while(symbols_iterate(symbols, &iter)!=-1)
+    for (index = 0; index < symbols->count; index++)
     {
-      if (iter.flag_export == 0) { continue; }
+      if ((symbols->flags[index] & SYMBOL_FLAG_EXPORT) == 0) { continue; }
 
       memset(&symtab, 0, sizeof(symtab));
       symtab.st_name = symbol_address[n++];
-      symtab.st_value = iter.address;
+      symtab.st_value = symbols->address[index];
       symtab.st_size = 0;
       symtab.st_info = 18;
       symtab.st_shndx = 1;
@@ -16,6 +16,7 @@ struct _table_powerpc table_powerpc[] =
   // Aliases
   { "blr",    0x4e800020, 0xffffffff, OP_NONE, FLAG_NONE, 0, 0 },
   { "li",     0x38000000, 0xfc0f0000, OP_RD_SIMM, FLAG_NONE, 0, 0 },
+  { "lis",    0x3c000000, 0xfc1f0000, OP_RD_SIMM, FLAG_NONE, 0, 0 },
   { "blt",    0x41800000, 0xffe30003, OP_BRANCH_COND_ALIAS, FLAG_NONE, 0, 0 },
   { "ble",    0x40810000, 0xffe30003, OP_BRANCH_COND_ALIAS, FLAG_NONE, 0, 0 },
   { "beq",    0x41820000, 0xffe30003, OP_BRANCH_COND_ALIAS, FLAG_NONE, 0, 0 },
@@ -186,3 +186,37 @@ struct _table_riscv table_riscv[] =
   { NULL, 0, 0, 0, 0 }
 };
 
+// Compressed instructions.  Order matters for disassembly, the more
+// specific masks have to come first.
+struct _table_riscv table_riscv_comp[] =
+{
+  { "c.nop",      0x0001, 0xffff, OP_C_NONE,     -1, -1 },
+  { "c.ebreak",   0x9002, 0xffff, OP_C_NONE,     -1, -1 },
+  { "c.addi4spn", 0x0000, 0xe003, OP_C_ADDI4SPN, -1, -1 },
+  { "c.lw",       0x4000, 0xe003, OP_C_LOAD,     -1, -1 },
+  { "c.sw",       0xc000, 0xe003, OP_C_STORE,    -1, -1 },
+  { "c.addi",     0x0001, 0xe003, OP_C_RD_IMM,   -1, -1 },
+  { "c.jal",      0x2001, 0xe003, OP_C_JUMP,     -1, -1 },
+  { "c.li",       0x4001, 0xe003, OP_C_RD_IMM,   -1, -1 },
+  { "c.addi16sp", 0x6101, 0xef83, OP_C_ADDI16SP, -1, -1 },
+  { "c.lui",      0x6001, 0xe003, OP_C_LUI,      -1, -1 },
+  { "c.srli",     0x8001, 0xec03, OP_C_SHIFT,    -1, -1 },
+  { "c.srai",     0x8401, 0xec03, OP_C_SHIFT,    -1, -1 },
+  { "c.andi",     0x8801, 0xec03, OP_C_ANDI,     -1, -1 },
+  { "c.sub",      0x8c01, 0xfc63, OP_C_ALU,      -1, -1 },
+  { "c.xor",      0x8c21, 0xfc63, OP_C_ALU,      -1, -1 },
+  { "c.or",       0x8c41, 0xfc63, OP_C_ALU,      -1, -1 },
+  { "c.and",      0x8c61, 0xfc63, OP_C_ALU,      -1, -1 },
+  { "c.j",        0xa001, 0xe003, OP_C_JUMP,     -1, -1 },
+  { "c.beqz",     0xc001, 0xe003, OP_C_BRANCH,   -1, -1 },
+  { "c.bnez",     0xe001, 0xe003, OP_C_BRANCH,   -1, -1 },
+  { "c.slli",     0x0002, 0xe003, OP_C_SLLI,     -1, -1 },
+  { "c.lwsp",     0x4002, 0xe003, OP_C_LWSP,     -1, -1 },
+  { "c.swsp",     0xc002, 0xe003, OP_C_SWSP,     -1, -1 },
+  { "c.jr",       0x8002, 0xf07f, OP_C_JR,       -1, -1 },
+  { "c.mv",       0x8002, 0xf003, OP_C_MV,       -1, -1 },
+  { "c.jalr",     0x9002, 0xf07f, OP_C_JR,       -1, -1 },
+  { "c.add",      0x9002, 0xf003, OP_C_MV,       -1, -1 },
+  { NULL, 0, 0, 0, 0 }
+};
+
@@ -45,6 +45,24 @@ enum
   OP_FP_FP_FP,
   OP_FP_FP_FP_RM,
   OP_FP_FP_FP_FP_RM,
+  // RVC (16 bit) formats.
+  OP_C_NONE,
+  OP_C_ADDI4SPN,
+  OP_C_LOAD,
+  OP_C_STORE,
+  OP_C_RD_IMM,
+  OP_C_JUMP,
+  OP_C_ADDI16SP,
+  OP_C_LUI,
+  OP_C_SHIFT,
+  OP_C_ANDI,
+  OP_C_ALU,
+  OP_C_BRANCH,
+  OP_C_SLLI,
+  OP_C_LWSP,
+  OP_C_SWSP,
+  OP_C_JR,
+  OP_C_MV,
 };
 
 struct _table_riscv
@@ -58,6 +76,7 @@ struct _table_riscv
 };
 
 extern struct _table_riscv table_riscv[];
+extern struct _table_riscv table_riscv_comp[];
 
 #endif
 
@@ -46,6 +46,7 @@ struct _table_instr_z80 table_instr_z80[] =
   { "indr", Z80_INDR },
   { "ini", Z80_INI },
   { "inir", Z80_INIR },
+  { "j", Z80_J },
   { "jp", Z80_JP },
   { "jr", Z80_JR },
   { "ld", Z80_LD },
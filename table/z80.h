@@ -128,6 +128,7 @@ enum
   Z80_INDR,
   Z80_INI,
   Z80_INIR,
+  Z80_J,
   Z80_JP,
   Z80_JR,
   Z80_LD,
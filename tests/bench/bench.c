@@ -0,0 +1,204 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/assembler.h"
+#include "fileio/write_hex.h"
+
+struct _timing
+{
+  double pass_1;
+  double pass_2;
+  double output;
+  int bytes;
+};
+
+static double get_time()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static int count_lines(const char *filename)
+{
+  FILE *in;
+  int count = 0;
+  int ch;
+
+  in = fopen(filename, "rb");
+  if (in == NULL) { return -1; }
+
+  while((ch = getc(in)) != EOF)
+  {
+    if (ch == '\n') { count++; }
+  }
+
+  fclose(in);
+
+  return count;
+}
+
+static int run(const char *filename, struct _timing *timing)
+{
+  struct _asm_context asm_context;
+  double start;
+  FILE *out;
+  int error_flag;
+
+  memset(&asm_context, 0, sizeof(asm_context));
+  asm_context.quiet_output = 1;
+
+  if (tokens_open_file(&asm_context, (char *)filename) != 0)
+  {
+    printf("Couldn't open %s for reading.\n", filename);
+    return -1;
+  }
+
+  out = tmpfile();
+
+  if (out == NULL)
+  {
+    printf("Couldn't open temp file for writing.\n");
+    tokens_close(&asm_context);
+    return -1;
+  }
+
+  symbols_init(&asm_context.symbols, &asm_context.names);
+  macros_init(&asm_context.macros, &asm_context.names);
+  listing_init(&asm_context.listing);
+  literals_init(&asm_context.literals);
+  relax_init(&asm_context.relax);
+
+  start = get_time();
+
+  asm_context.pass = 1;
+  assembler_init(&asm_context);
+  error_flag = assemble(&asm_context);
+  if (error_flag == 0) { error_flag = assembler_end_pass(&asm_context); }
+  if (error_flag == 0) { error_flag = assembler_relax(&asm_context); }
+
+  timing->pass_1 = get_time() - start;
+
+  if (error_flag == 0)
+  {
+    symbols_lock(&asm_context.symbols);
+    symbols_scope_reset(&asm_context.symbols);
+
+    start = get_time();
+
+    asm_context.pass = 2;
+    assembler_init(&asm_context);
+    error_flag = assemble(&asm_context);
+    if (error_flag == 0) { error_flag = assembler_end_pass(&asm_context); }
+
+    timing->pass_2 = get_time() - start;
+  }
+
+  if (error_flag == 0)
+  {
+    start = get_time();
+
+    write_hex(&asm_context.memory, out);
+    fflush(out);
+
+    timing->output = get_time() - start;
+  }
+
+  timing->bytes = asm_context.code_count + asm_context.data_count;
+
+  fclose(out);
+  tokens_close(&asm_context);
+  assembler_free(&asm_context);
+
+  if (error_flag != 0)
+  {
+    printf("Error: %s didn't assemble.\n", filename);
+    return -1;
+  }
+
+  return 0;
+}
+
+int main(int argc, char *argv[])
+{
+  struct _timing best, timing;
+  double total;
+  int repeat = 5;
+  int lines;
+  int n, i;
+
+  if (argc < 2)
+  {
+    printf("Usage: bench [-r <repeat>] <file.asm> ...\n");
+    exit(0);
+  }
+
+  printf("%-24s %8s %8s %9s %9s %9s %12s %12s\n",
+    "FILE", "LINES", "BYTES", "PASS1 ms", "PASS2 ms", "OUTPUT ms",
+    "LINES/SEC", "BYTES/SEC");
+
+  for (n = 1; n < argc; n++)
+  {
+    if (strcmp(argv[n], "-r") == 0 && n + 1 < argc)
+    {
+      repeat = atoi(argv[++n]);
+      if (repeat < 1) { repeat = 1; }
+      continue;
+    }
+
+    lines = count_lines(argv[n]);
+
+    if (lines < 0)
+    {
+      printf("Couldn't open %s for reading.\n", argv[n]);
+      return -1;
+    }
+
+    // Keep the fastest run of each phase so noise from the rest of the
+    // machine doesn't show up as a regression.
+    for (i = 0; i < repeat; i++)
+    {
+      if (run(argv[n], &timing) != 0) { return -1; }
+
+      if (i == 0)
+      {
+        best = timing;
+        continue;
+      }
+
+      if (timing.pass_1 < best.pass_1) { best.pass_1 = timing.pass_1; }
+      if (timing.pass_2 < best.pass_2) { best.pass_2 = timing.pass_2; }
+      if (timing.output < best.output) { best.output = timing.output; }
+    }
+
+    total = best.pass_1 + best.pass_2 + best.output;
+
+    printf("%-24s %8d %8d %9.2f %9.2f %9.2f %12.0f %12.0f\n",
+      argv[n],
+      lines,
+      best.bytes,
+      best.pass_1 * 1000,
+      best.pass_2 * 1000,
+      best.output * 1000,
+      lines / total,
+      best.bytes / total);
+  }
+
+  return 0;
+}
+
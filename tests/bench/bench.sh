@@ -0,0 +1,36 @@
+#!/usr/bin/env sh
+
+# Time every generated source and compare lines/sec against baseline.txt.
+# Run "make baseline" on a machine to store its numbers before comparing.
+#
+# Usage: bench.sh [baseline]
+
+THRESHOLD=10
+
+if [ "$1" = "baseline" ]
+then
+  ./bench *.asm | tee baseline.txt
+  exit 0
+fi
+
+./bench *.asm | tee results.txt || exit 1
+
+if [ ! -f baseline.txt ]
+then
+  echo "No baseline.txt, run 'make baseline' first."
+  exit 0
+fi
+
+echo
+awk -v threshold=$THRESHOLD '
+  FNR == 1 { next }
+  NR == FNR { baseline[$1] = $7; next }
+  {
+    if (!($1 in baseline)) { next }
+    change = (($7 - baseline[$1]) * 100) / baseline[$1]
+    status = change < -threshold ? "REGRESSION" : "ok"
+    if (status != "ok") { regressions++ }
+    printf("%-24s %+7.1f%% %s\n", $1, change, status)
+  }
+  END { if (regressions > 0) { exit 1 } }
+' baseline.txt results.txt
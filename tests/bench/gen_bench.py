@@ -0,0 +1,186 @@
+#!/usr/bin/env python
+
+# Generate large synthetic sources for the benchmark.  For every CPU that
+# has an instruction list in tests/comparison/<cpu>_template.txt this
+# writes <cpu>.asm (and <cpu>_include.inc) with lots of labels, .func
+# scopes, macros, defines and an include.
+#
+# Usage: gen_bench.py [lines_per_cpu] [cpu ...]
+
+import os, re, sys
+
+naken_asm = "../../naken_asm"
+template_dir = "../comparison"
+
+def assemble_file(filename):
+  ret = os.system(naken_asm + " -q -o temp.hex " + filename + " > temp.out")
+
+  fp = open("temp.out", "r")
+  output = fp.read()
+  fp.close()
+
+  # Some problems are only reported as errors without failing the build.
+  if ret == 0 and "Error" not in output: return None
+
+  return output
+
+def assembles_file(filename):
+  return assemble_file(filename) == None
+
+def get_failing_instruction(output, instructions):
+  # Errors look like "Error: ... at <file>:<line>".
+  m = re.search(r"Error:.* at (\S+):(\d+)", output)
+  if m == None or not os.path.exists(m.group(1)): return None
+
+  fp = open(m.group(1), "r")
+  lines = fp.readlines()
+  fp.close()
+
+  line = int(m.group(2))
+  if line < 1 or line > len(lines): return None
+
+  line = re.sub(r"^\.define BENCH_INSTR_\d+ ", "", lines[line - 1].strip())
+
+  if line in instructions: return line
+
+  return None
+
+def assembles(cpu, lines):
+  # Not at address 0 so relative branches to absolute addresses in the
+  # lists (only in range near 0) get dropped.
+  out = open("temp.asm", "w")
+  out.write("." + cpu + "\n")
+  out.write(".org 0x1000\n")
+  out.write("main:\n")
+  for line in lines:
+    out.write("  " + line + "\n")
+  out.close()
+
+  return assembles_file("temp.asm")
+
+def get_instructions(cpu):
+  instructions = []
+
+  fp = open(template_dir + "/" + cpu + "_template.txt", "r")
+
+  for line in fp:
+    line = line.strip()
+    if line == "" or line.startswith(";"): continue
+    if line.endswith(":"): continue
+    instructions.append(line)
+
+  fp.close()
+
+  # Most lists assemble as a whole so only check lines one at a time
+  # when that fails.
+  if assembles(cpu, instructions): return instructions
+
+  return [ x for x in instructions if assembles(cpu, [ x ]) ]
+
+def generate(cpu, instructions, total_lines):
+  include_name = cpu + "_include.inc"
+
+  out = open(include_name, "w")
+  out.write("; Generated by gen_bench.py\n\n")
+
+  for n in range(0, 64):
+    out.write(".define BENCH_CONST_%d %d\n" % (n, n * 3))
+
+  out.write("\n.macro bench_macro\n")
+  for n in range(0, 4):
+    out.write("  " + instructions[n % len(instructions)] + "\n")
+  out.write(".endm\n\n")
+
+  for n in range(0, 16):
+    out.write(".define BENCH_INSTR_%d %s\n" %
+      (n, instructions[(n * 7) % len(instructions)]))
+
+  out.close()
+
+  out = open(cpu + ".asm", "w")
+  out.write("; Generated by gen_bench.py\n")
+  out.write("." + cpu + "\n\n")
+  out.write(".include \"" + include_name + "\"\n\n")
+  out.write("main:\n")
+
+  lines = 5
+  func = 0
+  index = 0
+
+  while lines < total_lines:
+    out.write(".func bench_func_%d\n" % func)
+    lines += 1
+
+    for label in range(0, 8):
+      # Local labels are reused in every .func scope.
+      out.write("loop_%d:\n" % label)
+
+      for n in range(0, 6):
+        out.write("  " + instructions[index % len(instructions)] + "\n")
+        index += 1
+
+      out.write("  bench_macro\n")
+      out.write("  BENCH_INSTR_%d\n" % (index % 16))
+      lines += 9
+
+    out.write(".endf\n\n")
+    lines += 2
+
+    # Global labels too.
+    out.write("bench_global_%d:\n" % func)
+    lines += 1
+
+    func += 1
+
+  out.close()
+
+  return lines
+
+# --------------------------------- fold here -------------------------------
+
+total_lines = 100000
+cpus = [ ]
+
+if len(sys.argv) > 1: total_lines = int(sys.argv[1])
+
+if len(sys.argv) > 2:
+  cpus = sys.argv[2:]
+else:
+  for filename in sorted(os.listdir(template_dir)):
+    if filename.endswith("_template.txt"):
+      cpus.append(filename.replace("_template.txt", ""))
+
+for cpu in cpus:
+  instructions = get_instructions(cpu)
+
+  # An instruction that assembles on its own can still fail in the big
+  # source, for example a relative branch to an absolute address that is
+  # only in range near the start.  Drop it and try again.
+  while len(instructions) != 0:
+    lines = generate(cpu, instructions, total_lines)
+
+    output = assemble_file(cpu + ".asm")
+    if output == None: break
+
+    instruction = get_failing_instruction(output, instructions)
+
+    if instruction == None:
+      print(cpu + ": generated source doesn't assemble, skipping")
+      print("\n".join([ x for x in output.split("\n") if "Error" in x ]))
+      instructions = [ ]
+      break
+
+    print(cpu + ": dropping \"" + instruction + "\"")
+    instructions.remove(instruction)
+
+  if len(instructions) == 0:
+    print(cpu + ": no usable instructions, skipping")
+    for filename in [ cpu + ".asm", cpu + "_include.inc" ]:
+      if os.path.exists(filename): os.remove(filename)
+    continue
+
+  print("%s: %d lines (%d instructions)" % (cpu, lines, len(instructions)))
+
+for filename in [ "temp.asm", "temp.hex", "temp.out" ]:
+  if os.path.exists(filename): os.remove(filename)
+
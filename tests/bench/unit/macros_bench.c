@@ -0,0 +1,110 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/assembler.h"
+#include "common/macros.h"
+#include "timing.h"
+
+#define NAME_LEN 16
+#define LOOKUP_COUNT 100000
+
+int found = 0;
+
+void bench_macros(int count)
+{
+  struct _asm_context asm_context = { 0 };
+  double best_hit = 0, best_miss = 0;
+  double start, elapsed;
+  char *defined = malloc(count * NAME_LEN);
+  char *undefined = malloc(count * NAME_LEN);
+  char label[64];
+  uint32_t seed;
+  int param_count;
+  int run, n, i;
+
+  for (n = 0; n < count; n++)
+  {
+    sprintf(defined + (n * NAME_LEN), "MACRO_%d", n);
+    sprintf(undefined + (n * NAME_LEN), "OTHER_%d", n);
+  }
+
+  for (run = 0; run < TIMING_RUNS; run++)
+  {
+    symbols_init(&asm_context.symbols, &asm_context.names);
+    macros_init(&asm_context.macros, &asm_context.names);
+
+    for (n = 0; n < count; n++)
+    {
+      macros_append(&asm_context, defined + (n * NAME_LEN), "0x1234", 0);
+    }
+
+    seed = 1;
+    start = timing_get();
+
+    for (i = 0; i < LOOKUP_COUNT; i++)
+    {
+      n = timing_random(&seed) % count;
+
+      if (macros_lookup(&asm_context.macros, defined + (n * NAME_LEN), &param_count) != NULL)
+      {
+        found++;
+      }
+    }
+
+    elapsed = timing_get() - start;
+    if (run == 0 || elapsed < best_hit) { best_hit = elapsed; }
+
+    seed = 1;
+    start = timing_get();
+
+    for (i = 0; i < LOOKUP_COUNT; i++)
+    {
+      n = timing_random(&seed) % count;
+
+      if (macros_lookup(&asm_context.macros, undefined + (n * NAME_LEN), &param_count) != NULL)
+      {
+        found++;
+      }
+    }
+
+    elapsed = timing_get() - start;
+    if (run == 0 || elapsed < best_miss) { best_miss = elapsed; }
+
+    assembler_free(&asm_context);
+  }
+
+  sprintf(label, "macros_lookup %d hit", count);
+  timing_print(label, LOOKUP_COUNT, best_hit);
+  sprintf(label, "macros_lookup %d miss", count);
+  timing_print(label, LOOKUP_COUNT, best_miss);
+
+  free(defined);
+  free(undefined);
+}
+
+int main(int argc, char *argv[])
+{
+  int count;
+
+  for (count = 10; count <= 1000; count *= 10)
+  {
+    bench_macros(count);
+  }
+
+  printf("found=%d\n", found);
+
+  return 0;
+}
+
@@ -0,0 +1,83 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/assembler.h"
+#include "common/memory.h"
+#include "timing.h"
+
+#define SEQUENTIAL_COUNT (1 << 19)
+#define SCATTERED_COUNT (1 << 16)
+#define SCATTERED_RANGE (1 << 22)
+
+uint32_t checksum = 0;
+
+void bench_memory(const char *name, int count, int scattered)
+{
+  struct _asm_context asm_context = { 0 };
+  double best_write = 0, best_read = 0;
+  double start, elapsed;
+  uint32_t seed;
+  uint32_t address;
+  char label[64];
+  int run, n;
+
+  for (run = 0; run < TIMING_RUNS; run++)
+  {
+    memory_init(&asm_context.memory, ~((uint32_t)0), 1);
+
+    seed = 1;
+    start = timing_get();
+
+    for (n = 0; n < count; n++)
+    {
+      address = scattered == 0 ? n : timing_random(&seed) % SCATTERED_RANGE;
+      memory_write(&asm_context, address, n & 0xff, n);
+    }
+
+    elapsed = timing_get() - start;
+    if (run == 0 || elapsed < best_write) { best_write = elapsed; }
+
+    seed = 1;
+    start = timing_get();
+
+    for (n = 0; n < count; n++)
+    {
+      address = scattered == 0 ? n : timing_random(&seed) % SCATTERED_RANGE;
+      checksum += memory_read(&asm_context, address);
+    }
+
+    elapsed = timing_get() - start;
+    if (run == 0 || elapsed < best_read) { best_read = elapsed; }
+
+    memory_free(&asm_context.memory);
+  }
+
+  sprintf(label, "memory_write %s", name);
+  timing_print(label, count, best_write);
+  sprintf(label, "memory_read %s", name);
+  timing_print(label, count, best_read);
+}
+
+int main(int argc, char *argv[])
+{
+  bench_memory("sequential", SEQUENTIAL_COUNT, 0);
+  bench_memory("scattered", SCATTERED_COUNT, 1);
+
+  // Printed so the reads can't be optimized away.
+  printf("checksum=%08x\n", checksum);
+
+  return 0;
+}
+
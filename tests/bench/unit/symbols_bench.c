@@ -0,0 +1,136 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/names.h"
+#include "common/symbols.h"
+#include "timing.h"
+
+// Number of local labels in each scope when testing with scopes.
+#define LABELS_PER_SCOPE 8
+
+#define NAME_LEN 16
+
+int found = 0;
+
+static char *get_names(int count, int use_scopes)
+{
+  char *names = malloc(count * NAME_LEN);
+  int n;
+
+  for (n = 0; n < count; n++)
+  {
+    if (use_scopes == 0)
+    {
+      sprintf(names + (n * NAME_LEN), "label_%d", n);
+    }
+      else
+    {
+      // Same local names reused in every scope like .func loop labels.
+      sprintf(names + (n * NAME_LEN), "loop_%d", n % LABELS_PER_SCOPE);
+    }
+  }
+
+  return names;
+}
+
+void bench_symbols(int count, int use_scopes)
+{
+  struct _symbols symbols;
+  double best_append = 0, best_find = 0;
+  double start, elapsed;
+  uint32_t address;
+  uint32_t seed;
+  char *names = get_names(count, use_scopes);
+  struct _names pool;
+  char label[64];
+  int run, n, i;
+
+  for (run = 0; run < TIMING_RUNS; run++)
+  {
+    names_init(&pool);
+    symbols_init(&symbols, &pool);
+
+    start = timing_get();
+
+    for (n = 0; n < count; n++)
+    {
+      if (use_scopes == 1 && (n % LABELS_PER_SCOPE) == 0)
+      {
+        symbols_scope_end(&symbols);
+        symbols_scope_start(&symbols);
+      }
+
+      symbols_append(&symbols, names + (n * NAME_LEN), n);
+    }
+
+    symbols_scope_end(&symbols);
+
+    elapsed = timing_get() - start;
+    if (run == 0 || elapsed < best_append) { best_append = elapsed; }
+
+    // Look names up in random order (from inside the right scope when
+    // using scopes) the way pass 2 resolves label references.
+    symbols_lock(&symbols);
+    symbols_scope_reset(&symbols);
+
+    seed = 1;
+    start = timing_get();
+
+    for (i = 0; i < count; i++)
+    {
+      n = timing_random(&seed) % count;
+
+      if (use_scopes == 1)
+      {
+        symbols.in_scope = 1;
+        symbols.current_scope = (n / LABELS_PER_SCOPE) + 1;
+      }
+
+      if (symbols_lookup(&symbols, names + (n * NAME_LEN), &address) == 0)
+      {
+        found++;
+      }
+    }
+
+    elapsed = timing_get() - start;
+    if (run == 0 || elapsed < best_find) { best_find = elapsed; }
+
+    symbols_free(&symbols);
+    names_free(&pool);
+  }
+
+  free(names);
+
+  sprintf(label, "symbols_append %d%s", count, use_scopes ? " scopes" : "");
+  timing_print(label, count, best_append);
+  sprintf(label, "symbols_find %d%s", count, use_scopes ? " scopes" : "");
+  timing_print(label, count, best_find);
+}
+
+int main(int argc, char *argv[])
+{
+  int count;
+
+  for (count = 1000; count <= 100000; count *= 10)
+  {
+    bench_symbols(count, 0);
+    bench_symbols(count, 1);
+  }
+
+  printf("found=%d\n", found);
+
+  return 0;
+}
+
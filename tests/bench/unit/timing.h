@@ -0,0 +1,47 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#ifndef _TIMING_H
+#define _TIMING_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+// Every benchmark is run this many times and the fastest is reported
+// so numbers are comparable before and after a change.
+#define TIMING_RUNS 5
+
+static inline double timing_get()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+// Fixed seed random numbers so every run does the same work.
+static inline uint32_t timing_random(uint32_t *seed)
+{
+  *seed = (*seed * 1103515245) + 12345;
+
+  return *seed >> 8;
+}
+
+static inline void timing_print(const char *name, int ops, double seconds)
+{
+  printf("%-40s %9d ops %10.1f ns/op\n",
+    name, ops, (seconds * 1000000000.0) / ops);
+}
+
+#endif
+
@@ -0,0 +1,86 @@
+/**
+ *  naken_asm assembler.
+ *  Author: Michael Kohn
+ *   Email: mike@mikekohn.net
+ *     Web: http://www.mikekohn.net/
+ * License: GPL
+ *
+ * Copyright 2010-2017 by Michael Kohn
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/assembler.h"
+#include "common/tokens.h"
+#include "timing.h"
+
+#define LINE_COUNT 100000
+
+const char *lines[] =
+{
+  "label_%d:\n",
+  "  mov.w #0x%04x, r%d\n",
+  "  add.w @r4+, 2(r%d)  ; comment %d\n",
+  "  .db \"string %d\", 0, 1, 'a'\n",
+  "  jmp label_%d\n",
+  "  .dw 100b, 0%oq, %dh + (5 * 3)\n",
+};
+
+char *build_source(int line_count, int *len)
+{
+  char *source = malloc(line_count * 64);
+  int ptr = 0;
+  int n;
+
+  for (n = 0; n < line_count; n++)
+  {
+    ptr += sprintf(source + ptr, lines[n % 6], n, n % 16, n);
+  }
+
+  *len = ptr;
+
+  return source;
+}
+
+int main(int argc, char *argv[])
+{
+  struct _asm_context asm_context = { 0 };
+  char token[TOKENLEN];
+  double best = 0;
+  double start, elapsed;
+  char *source;
+  int count = 0;
+  int len;
+  int run;
+
+  source = build_source(LINE_COUNT, &len);
+
+  for (run = 0; run < TIMING_RUNS; run++)
+  {
+    tokens_open_buffer(&asm_context, source);
+    tokens_reset(&asm_context);
+
+    count = 0;
+    start = timing_get();
+
+    while(tokens_get(&asm_context, token, TOKENLEN) != TOKEN_EOF)
+    {
+      count++;
+    }
+
+    elapsed = timing_get() - start;
+    if (run == 0 || elapsed < best) { best = elapsed; }
+  }
+
+  timing_print("tokens_get", count, best);
+  printf("%-40s %9d bytes %8.1f MB/s\n", "tokens_get buffer", len,
+    (len / best) / 1000000.0);
+
+  free(source);
+
+  return 0;
+}
+
@@ -0,0 +1,4 @@
+.riscv
+
+start:
+  fence
@@ -0,0 +1,9 @@
+.pic14
+.banktrack
+
+;; The second banksel is already in bank 1 so nothing is left of it.
+
+  banksel 0x85
+  clrf 0x85
+  banksel 0x86
+  clrf 0x86
@@ -0,0 +1,28 @@
+#!/usr/bin/env python
+
+import os,sys
+
+p = os.popen("../../../naken_asm -l banksel.asm")
+while 1:
+  line = p.readline()
+  if line == "": break
+p.close()
+
+fp = open("out.lst", "rb")
+lines = [ line.strip() for line in fp.readlines() ]
+fp.close()
+
+os.unlink("out.hex")
+os.unlink("out.lst")
+
+print "banksel test:",
+
+# The (shortened) mark has to be on the banksel that was left out, not
+# on the clrf after it.
+n = lines.index("banksel 0x86")
+
+if lines[n + 2] == "(shortened)" and lines[n + 4] == "clrf 0x86":
+  print "\x1b[32mPASS\x1b[0m"
+else:
+  print "\x1b[31mFAIL\x1b[0m"
+  sys.exit(-1)
@@ -0,0 +1,14 @@
+.mips
+.set reorder
+
+;; The sw and addu are moved into the delay slots, so in the listing
+;; they have to be after the branches they now follow.
+
+start:
+  addiu $t0, $t0, 1
+  sw $a0, 4($a1)
+  bne $t1, $t2, start
+  nop
+  addu $v0, $a0, $a1
+  jr $ra
+  nop
@@ -0,0 +1,39 @@
+#!/usr/bin/env python
+
+import os,sys
+
+p = os.popen("../../../naken_asm -l delay_slot.asm")
+while 1:
+  line = p.readline()
+  if line == "": break
+p.close()
+
+fp = open("out.lst", "rb")
+lines = [ line.strip() for line in fp.readlines() ]
+fp.close()
+
+os.unlink("out.hex")
+os.unlink("out.lst")
+
+print "Delay slot test:",
+
+# Each source line is followed by a blank line and then its address.
+expected = \
+[
+  [ "sw $a0, 4($a1)", "0x00000008: 0xaca40004" ],
+  [ "bne $t1, $t2, start", "0x00000004: 0x152afffe" ],
+  [ "addu $v0, $a0, $a1", "0x00000010: 0x00851021" ],
+  [ "jr $ra", "0x0000000c: 0x03e00008" ],
+]
+
+errors = 0
+
+for source, code in expected:
+  n = lines.index(source)
+  if not lines[n + 2].startswith(code): errors += 1
+
+if errors == 0:
+  print "\x1b[32mPASS\x1b[0m"
+else:
+  print "\x1b[31mFAIL\x1b[0m"
+  sys.exit(-1)
@@ -0,0 +1,10 @@
+.65816
+
+.dp 0x2000
+
+; jmp and jsr have no direct page form so they stay absolute.
+jmp 0x2010
+jsr 0x2010
+
+; lda 0x2010 is in the direct page at offset 0x10.
+lda 0x2010
@@ -0,0 +1,24 @@
+#!/usr/bin/env python
+
+import os,sys
+
+p = os.popen("../../../naken_asm direct_page.asm")
+while 1:
+  line = p.readline()
+  if line == "": break
+p.close()
+
+fp = open("out.hex", "rb")
+line = fp.readline().strip()
+fp.close()
+
+os.unlink("out.hex")
+
+print "Direct page test:",
+
+if line[9:25] == "4C1020201020A510":
+  print "\x1b[32mPASS\x1b[0m"
+else:
+  print "\x1b[31mFAIL\x1b[0m"
+  sys.exit(-1)
+
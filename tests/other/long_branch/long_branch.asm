@@ -0,0 +1,12 @@
+.6809
+
+;; bra and bsr can't reach far so they become lbra and lbsr.
+
+start:
+  bra far
+  bsr far
+  lbra start
+  lbsr start
+  .ds8 300
+far:
+  rts
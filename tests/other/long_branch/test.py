@@ -0,0 +1,39 @@
+#!/usr/bin/env python
+
+import os,sys
+
+p = os.popen("../../../naken_asm -l long_branch.asm")
+while 1:
+  line = p.readline()
+  if line == "": break
+p.close()
+
+fp = open("out.lst", "rb")
+lines = [ line.strip() for line in fp.readlines() ]
+fp.close()
+
+os.unlink("out.hex")
+os.unlink("out.lst")
+
+print "6809 long branch test:",
+
+# Each source line is followed by a blank line and then its listing.
+expected = \
+[
+  [ "bra far", "0x0000: 16 01 35         lbra 0x0138 (309)" ],
+  [ "bsr far", "0x0003: 17 01 32         lbsr 0x0138 (306)" ],
+  [ "lbra start", "0x0006: 16 ff f7         lbra 0x0000 (-9)" ],
+  [ "lbsr start", "0x0009: 17 ff f4         lbsr 0x0000 (-12)" ],
+]
+
+errors = 0
+
+for source, code in expected:
+  n = lines.index(source)
+  if not lines[n + 2].startswith(code): errors += 1
+
+if errors == 0:
+  print "\x1b[32mPASS\x1b[0m"
+else:
+  print "\x1b[31mFAIL\x1b[0m"
+  sys.exit(-1)
@@ -0,0 +1,12 @@
+.riscv
+
+;; The same jal and beq assembled as 32 bit instructions and compressed
+;; by .relax have to go to the same place.
+
+start:
+  jal x0, start
+  beq x8, x0, start
+.relax
+  jal x0, start
+  beq x8, x0, start
+.norelax
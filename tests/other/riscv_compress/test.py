@@ -0,0 +1,24 @@
+#!/usr/bin/env python
+
+import os,sys
+
+p = os.popen("../../../naken_asm riscv_compress.asm")
+while 1:
+  line = p.readline()
+  if line == "": break
+p.close()
+
+fp = open("out.hex", "rb")
+line = fp.readline().strip()
+fp.close()
+
+os.unlink("out.hex")
+
+print "RISC-V compress test:",
+
+# jal x0, start / beq x8, x0, start then c.j start / c.beqz x8, start
+if line[9:33] == "6F000000E30E04FEE5BF7DD8":
+  print "\x1b[32mPASS\x1b[0m"
+else:
+  print "\x1b[31mFAIL\x1b[0m"
+  sys.exit(-1)
@@ -24,8 +24,8 @@ int test_symbols(const char *label, const char *code)
 
   printf("%s\n", code);
 
-  symbols_init(&asm_context.symbols);
-  macros_init(&asm_context.macros);
+  symbols_init(&asm_context.symbols, &asm_context.names);
+  macros_init(&asm_context.macros, &asm_context.names);
 
   asm_context.pass = 1;
   assembler_init(&asm_context);
@@ -21,6 +21,9 @@ void test(const char *macro, const char **answer)
 
   printf("Testing: %s ... ", macro);
 
+  symbols_init(&asm_context.symbols, &asm_context.names);
+  macros_init(&asm_context.macros, &asm_context.names);
+
   tokens_open_buffer(&asm_context, macro);
   tokens_reset(&asm_context);
 
@@ -69,6 +72,8 @@ void test(const char *macro, const char **answer)
   }
 
   tokens_close(&asm_context);
+  macros_free(&asm_context.macros);
+  names_free(&asm_context.names);
 }
 
 int main(int argc, char *argv[])
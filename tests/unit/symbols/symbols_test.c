@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "common/names.h"
 #include "common/symbols.h"
 
 int errors = 0;
@@ -51,8 +52,10 @@ void check_export(struct _symbols *symbols, char *name, int expected)
 int main(int argc, char *argv[])
 {
   struct _symbols symbols;
+  struct _names names;
 
-  symbols_init(&symbols);
+  names_init(&names);
+  symbols_init(&symbols, &names);
 
   append(&symbols, "test1", 100);
   append(&symbols, "test2", 200);
@@ -119,6 +122,7 @@ int main(int argc, char *argv[])
   }
 
   symbols_free(&symbols);
+  names_free(&names);
 
   printf("Total errors: %d\n", errors);
   printf("%s\n", errors == 0 ? "PASSED." : "FAILED.");